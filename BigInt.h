@@ -0,0 +1,368 @@
+#pragma once
+
+// Длинные целые из задания Z5.cpp; используются также в Z2.cpp для
+// точной проверки знака дискриминанта
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <iomanip>
+#include <list>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const uint32_t BASE = 1000000000; // 10^9
+
+// Класс для работы с большими неотрицательными числами
+class BigInt {
+public:
+    // младший чанк — в front(), старший — в back()
+    std::list<uint32_t> chunks;
+    bool negative = false;
+
+    BigInt() = default;
+
+    // Парсинг из строки (только цифры, до 200 символов)
+    static BigInt fromString(const std::string &s) {
+        if (s.empty() || s.size() > 200)
+            throw std::invalid_argument("Неверная длина числа");
+        for (char c : s)
+            if (!std::isdigit(c))
+                throw std::invalid_argument("Неверный символ в числе");
+
+        BigInt R;
+        int len = int(s.size());
+        for (int i = len; i > 0; i -= 9) {
+            int start = std::max(0, i - 9);
+            int count = i - start;
+            uint32_t chunk = std::stoul(s.substr(start, count));
+            R.chunks.push_back(chunk);
+        }
+        R.trim();
+        return R;
+    }
+
+    // Из машинного целого, без разбора строки
+    static BigInt fromU64(uint64_t v) {
+        BigInt R;
+        do {
+            R.chunks.push_back(uint32_t(v % BASE));
+            v /= BASE;
+        } while (v);
+        return R;
+    }
+
+    // Удаляем ведущие нулевые чанки (верхний край), оставляем хотя бы один
+    void trim() {
+        while (chunks.size() > 1 && chunks.back() == 0)
+            chunks.pop_back();
+        if (chunks.size() == 1 && chunks.front() == 0)
+            negative = false;
+    }
+
+    // Сравнение по абсолютному значению
+    static int cmpAbs(const BigInt &A, const BigInt &B) {
+        if (A.chunks.size() != B.chunks.size())
+            return A.chunks.size() < B.chunks.size() ? -1 : +1;
+        // одинаковая длина — сравниваем от старшего чанка
+        auto a_it = A.chunks.rbegin();
+        auto b_it = B.chunks.rbegin();
+        while (a_it != A.chunks.rend()) {
+            if (*a_it != *b_it)
+                return *a_it < *b_it ? -1 : +1;
+            ++a_it; ++b_it;
+        }
+        return 0;
+    }
+
+    // Сложение абсолютных значений
+    static BigInt addAbs(const BigInt &A, const BigInt &B) {
+        BigInt R;
+        auto itA = A.chunks.begin();
+        auto itB = B.chunks.begin();
+        uint64_t carry = 0;
+        while (itA != A.chunks.end() || itB != B.chunks.end() || carry) {
+            uint64_t a = (itA != A.chunks.end() ? *itA++ : 0);
+            uint64_t b = (itB != B.chunks.end() ? *itB++ : 0);
+            uint64_t sum = a + b + carry;
+            R.chunks.push_back(uint32_t(sum % BASE));
+            carry = sum / BASE;
+        }
+        return R;
+    }
+
+    // Вычитание абсолютных значений: предполагаем A >= B
+    static BigInt subAbs(const BigInt &A, const BigInt &B) {
+        BigInt R;
+        auto itA = A.chunks.begin();
+        auto itB = B.chunks.begin();
+        int64_t borrow = 0;
+        while (itA != A.chunks.end()) {
+            int64_t a = int64_t(*itA++) - borrow;
+            int64_t b = (itB != B.chunks.end() ? *itB++ : 0);
+            if (a < b) {
+                a += BASE;
+                borrow = 1;
+            } else {
+                borrow = 0;
+            }
+            R.chunks.push_back(uint32_t(a - b));
+        }
+        R.trim();
+        return R;
+    }
+
+    // Операция сложения с учётом знака
+    BigInt operator+(const BigInt &other) const {
+        if (negative == other.negative) {
+            BigInt R = addAbs(*this, other);
+            R.negative = negative;
+            R.trim();
+            return R;
+        } else {
+            // A + (-B) = A - B
+            if (cmpAbs(*this, other) >= 0) {
+                BigInt R = subAbs(*this, other);
+                R.negative = negative;
+                R.trim();
+                return R;
+            } else {
+                BigInt R = subAbs(other, *this);
+                R.negative = other.negative;
+                R.trim();
+                return R;
+            }
+        }
+    }
+
+    // Вычитание с учётом знака
+    BigInt operator-(const BigInt &other) const {
+        if (negative != other.negative) {
+            // A - (-B) = A + B
+            BigInt R = addAbs(*this, other);
+            R.negative = negative;
+            R.trim();
+            return R;
+        } else {
+            // A - B = ?
+            if (cmpAbs(*this, other) >= 0) {
+                BigInt R = subAbs(*this, other);
+                R.negative = negative;
+                R.trim();
+                return R;
+            } else {
+                BigInt R = subAbs(other, *this);
+                R.negative = !negative;
+                R.trim();
+                return R;
+            }
+        }
+    }
+
+    // Умножение методом «столбиком»
+    BigInt operator*(const BigInt &other) const {
+        // переводим в вектор для удобного индексирования
+        std::vector<uint64_t> a(chunks.begin(), chunks.end());
+        std::vector<uint64_t> b(other.chunks.begin(), other.chunks.end());
+        std::vector<uint64_t> res(a.size() + b.size(), 0);
+
+        for (size_t i = 0; i < a.size(); ++i) {
+            uint64_t carry = 0;
+            for (size_t j = 0; j < b.size() || carry; ++j) {
+                uint64_t cur = res[i + j] +
+                    a[i] * (j < b.size() ? b[j] : 0) +
+                    carry;
+                res[i + j] = cur % BASE;
+                carry = cur / BASE;
+            }
+        }
+        BigInt R;
+        R.negative = (negative != other.negative);
+        // переносим ненулевые части в список
+        size_t k = res.size();
+        while (k > 1 && res[k-1] == 0) --k;
+        for (size_t i = 0; i < k; ++i)
+            R.chunks.push_back(uint32_t(res[i]));
+        R.trim();
+        return R;
+    }
+
+    // Преобразование обратно в десятичную строку
+    std::string toString() const {
+        if (chunks.empty()) return "0";
+        std::string s;
+        if (negative) s.push_back('-');
+        // самый старший чанк без ведущих нулей
+        auto it = chunks.rbegin();
+        s += std::to_string(*it++);
+        // остальные — ровно 9 цифр с ведущими нулями
+        for (; it != chunks.rend(); ++it) {
+            std::ostringstream oss;
+            oss << std::setw(9) << std::setfill('0') << *it;
+            s += oss.str();
+        }
+        return s;
+    }
+};
+
+// Накопитель сумм произведений. Столбец k копит без переносов сумму
+// произведений чанков с i + j = k; переносы нормализуются один раз в
+// value(). Столбец — 128 бит, где их поддерживает компилятор (тогда
+// переполнение на практике недостижимо), иначе 64 бита с нормализацией
+// каждые kFoldRows строк. Положительные и отрицательные слагаемые копятся
+// отдельно и вычитаются в конце.
+class BigIntAccumulator {
+public:
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 Column;
+#else
+    using Column = uint64_t;
+#endif
+
+    // += x
+    void add(const BigInt &x) {
+        load(x, scratchA);
+        addLimbs(x.negative ? neg : pos, scratchA.data(), scratchA.size());
+    }
+
+    // += a * b
+    void addProduct(const BigInt &a, const BigInt &b) {
+        load(a, scratchA);
+        load(b, scratchB);
+        addProduct(scratchA.data(), scratchA.size(), scratchB.data(), scratchB.size(),
+                   a.negative != b.negative);
+    }
+
+    // += (±) a * b над готовыми чанками (младший первый)
+    void addProduct(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, bool negative) {
+        if (na > nb) {   // строк меньше — реже нормализация
+            std::swap(a, b);
+            std::swap(na, nb);
+        }
+        Part &p = negative ? neg : pos;
+        if (p.cols.size() < na + nb) p.cols.resize(na + nb, 0);
+        for (size_t i = 0; i < na; ++i) {
+            if (p.rows == kFoldRows) fold(p);
+            ++p.rows;
+            uint64_t x = a[i];
+            Column *c = &p.cols[i];
+            for (size_t j = 0; j < nb; ++j)
+                c[j] += Column(x * b[j]);
+        }
+    }
+
+    BigInt value() const {
+        Part P = pos, N = neg;
+        fold(P);
+        fold(N);
+        return toBigInt(P) - toBigInt(N);
+    }
+
+    void clear() {
+        pos = Part();
+        neg = Part();
+    }
+
+private:
+    struct Part {
+        std::vector<Column> cols;
+        uint64_t rows = 0;   // строк с последней нормализации
+    };
+
+    // После нормализации столбец < BASE, строка добавляет к нему меньше
+    // (BASE-1)^2; половина диапазона оставляет место переносу при свёртке
+    static constexpr Column kMaxRows = Column(~Column(0)) / 2 / (Column(BASE - 1) * (BASE - 1));
+    static constexpr uint64_t kFoldRows = kMaxRows > Column(UINT64_MAX) ? UINT64_MAX : uint64_t(kMaxRows);
+
+    static void load(const BigInt &x, std::vector<uint32_t> &out) {
+        out.assign(x.chunks.begin(), x.chunks.end());
+        if (out.empty()) out.push_back(0);
+    }
+
+    void addLimbs(Part &p, const uint32_t *x, size_t n) {
+        if (p.cols.size() < n) p.cols.resize(n, 0);
+        if (p.rows == kFoldRows) fold(p);
+        ++p.rows;
+        for (size_t i = 0; i < n; ++i) p.cols[i] += x[i];
+    }
+
+    static void fold(Part &p) {
+        Column carry = 0;
+        for (Column &c : p.cols) {
+            Column v = c + carry;
+            c = v % BASE;
+            carry = v / BASE;
+        }
+        while (carry) {
+            p.cols.push_back(carry % BASE);
+            carry /= BASE;
+        }
+        p.rows = 0;
+    }
+
+    static BigInt toBigInt(const Part &p) {
+        BigInt R;
+        for (Column c : p.cols) R.chunks.push_back(uint32_t(c));
+        if (R.chunks.empty()) R.chunks.push_back(0);
+        R.trim();
+        return R;
+    }
+
+    Part pos, neg;
+    std::vector<uint32_t> scratchA, scratchB;
+};
+
+// Σ a[i] * b[i]
+inline BigInt dot(const std::vector<BigInt> &a, const std::vector<BigInt> &b) {
+    if (a.size() != b.size())
+        throw std::invalid_argument("Векторы разной длины");
+    BigIntAccumulator acc;
+    for (size_t i = 0; i < a.size(); ++i)
+        acc.addProduct(a[i], b[i]);
+    return acc.value();
+}
+
+// Σ first * second по всем парам
+inline BigInt sumOfProducts(const std::vector<std::pair<BigInt, BigInt>> &terms) {
+    BigIntAccumulator acc;
+    for (const auto &t : terms)
+        acc.addProduct(t.first, t.second);
+    return acc.value();
+}
+
+// Σ coeffs[i] * x^i. Степени x нормализуются (они нужны для следующей),
+// а произведения на коэффициенты копятся без переносов
+inline BigInt polynomial(const std::vector<BigInt> &coeffs, const BigInt &x) {
+    std::vector<uint32_t> xs(x.chunks.begin(), x.chunks.end());
+    if (xs.empty()) xs.push_back(0);
+    std::vector<uint32_t> power{1}, next, c;
+    BigIntAccumulator acc;
+    for (size_t i = 0; i < coeffs.size(); ++i) {
+        c.assign(coeffs[i].chunks.begin(), coeffs[i].chunks.end());
+        if (c.empty()) c.push_back(0);
+        bool negative = coeffs[i].negative != (x.negative && (i & 1));
+        acc.addProduct(c.data(), c.size(), power.data(), power.size(), negative);
+        if (i + 1 == coeffs.size()) break;
+
+        // power *= x
+        next.assign(power.size() + xs.size(), 0);
+        for (size_t a = 0; a < power.size(); ++a) {
+            uint64_t carry = 0;
+            for (size_t b = 0; b < xs.size(); ++b) {
+                uint64_t cur = next[a + b] + uint64_t(power[a]) * xs[b] + carry;
+                next[a + b] = uint32_t(cur % BASE);
+                carry = cur / BASE;
+            }
+            for (size_t k = a + xs.size(); carry; ++k) {
+                uint64_t cur = next[k] + carry;
+                next[k] = uint32_t(cur % BASE);
+                carry = cur / BASE;
+            }
+        }
+        while (next.size() > 1 && next.back() == 0) next.pop_back();
+        power.swap(next);
+    }
+    return acc.value();
+}
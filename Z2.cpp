@@ -2,11 +2,325 @@
 #include <iostream>
 #include <cmath>
 #include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "BigInt.h"
+
+// ==== Знак дискриминанта ====
+//
+// Число корней решает знак D = b*b - 4*a*c, и сравнение с фиксированным eps
+// ошибается на плохо масштабированных и почти вырожденных уравнениях.
+// Поэтому оба произведения раскладываются без потерь на сумму двух double,
+// а к приближённому D прилагается оценка погрешности; если |D| больше
+// оценки, знак верен. Иначе коэффициенты приводятся степенями двойки к
+// порядку единицы (знак D от этого не меняется) и проверка повторяется, а
+// если и это не помогло — знак находится точно, длинной арифметикой над
+// двоичными значениями коэффициентов.
+
+enum class Roots { None, One, Two };
+
+// Каким путём найден знак
+enum class Path { Fast, Rescaled, Exact };
+
+struct Discriminant {
+    double value;   // приближённое D
+    Roots kind;     // по верному знаку D
+    Path path;
+};
+
+// p + e == x * y точно (если нет переполнения и денормалов)
+static inline void twoProduct(double x, double y, double& p, double& e) {
+    p = x * y;
+#ifdef FP_FAST_FMA
+    e = std::fma(x, y, -p);
+#else
+    // Без аппаратного FMA std::fma программный и медленный — разбиение Деккера
+    const double split = 134217729.0;   // 2^27 + 1
+    double t = split * x, xh = t - (t - x), xl = x - xh;
+    t = split * y;
+    double yh = t - (t - y), yl = y - yh;
+    e = ((xh * yh - p) + xh * yl + xl * yh) + xl * yl;
+#endif
+}
+
+// None/One/Two по знаку d, без ветвлений
+static inline Roots signOf(double d) {
+    return Roots(2 * int(d > 0) + int(d == 0));
+}
+
+// Приближённое D; certified — его знак заведомо верен
+static inline double compensated(double a, double b, double c, bool& certified) {
+    double p, pe, q, qe;
+    twoProduct(b, b, p, pe);
+    twoProduct(a, c, q, qe);
+    // D = (p - 4q) + (pe - 4qe) точно; три сложения дают по ошибке в
+    // полединицы последнего разряда, 2u с запасом покрывают и их, и
+    // округление самой оценки
+    double s = p - 4.0 * q;
+    double t = pe - 4.0 * qe;
+    double d = s + t;
+    double bound = 0x1p-52 * (std::fabs(s) + std::fabs(t) + std::fabs(d));
+    // Разложение точно, пока произведения не переполнились и их младшие
+    // части не ушли в денормалы; проверки без ветвлений
+    double mp = std::fabs(p), mq = std::fabs(q);
+    certified = ((std::fabs(d) > bound) | (bound == 0.0))
+              & (mp < 0x1p1000) & ((mp > 0x1p-960) | (b == 0.0))
+              & (mq < 0x1p1000) & ((mq > 0x1p-960) | (c == 0.0));
+    return d;
+}
+
+// x = m * 2^e, |m| < 2^53 — целое
+static void decompose(double x, int64_t& m, int& e) {
+    int k;
+    double f = std::frexp(x, &k);
+    m = int64_t(std::ldexp(f, 53));
+    e = k - 53;
+}
+
+static BigInt pow2(int k) {
+    BigInt r = BigInt::fromU64(1), base = BigInt::fromU64(2);
+    for (; k; k >>= 1) {
+        if (k & 1) r = r * base;
+        base = base * base;
+    }
+    return r;
+}
+
+// Точный знак b*b - 4*a*c для конечных a, b, c
+static Roots exactSign(double a, double b, double c) {
+    if (a == 0.0 || c == 0.0) return b == 0.0 ? Roots::One : Roots::Two;
+    bool acPositive = (a > 0) == (c > 0);
+    if (b == 0.0) return acPositive ? Roots::None : Roots::Two;
+
+    int64_t ma, mb, mc;
+    int ea, eb, ec;
+    decompose(a, ma, ea);
+    decompose(b, mb, eb);
+    decompose(c, mc, ec);
+    // D * 2^-E = mb^2 * 2^(2eb - E) - ma*mc * 2^(ea + ec + 2 - E)
+    int E = std::min(2 * eb, ea + ec + 2);
+    BigInt bm = BigInt::fromU64(uint64_t(mb < 0 ? -mb : mb));
+    BigInt bb = bm * bm * pow2(2 * eb - E);
+    BigInt ac = BigInt::fromU64(uint64_t(ma < 0 ? -ma : ma)) * BigInt::fromU64(uint64_t(mc < 0 ? -mc : mc))
+              * pow2(ea + ec + 2 - E);
+    ac.negative = !acPositive;
+    BigInt D = bb - ac;
+    if (D.chunks.size() == 1 && D.chunks.front() == 0) return Roots::One;
+    return D.negative ? Roots::None : Roots::Two;
+}
+
+// Знак D не меняется при a -> a*2^i, c -> c*2^k, b -> b*2^j, если i + k = 2j:
+// a и c приводятся к [1, 4), и если b после этого далеко от единицы, знак
+// ясен сразу, иначе повторяется быстрая проверка
+static Roots rescaledSign(double a, double b, double c, Path& path) {
+    path = Path::Rescaled;
+    if (b == 0.0 || c == 0.0) return exactSign(a, b, c);   // без длинных чисел
+    int i = -std::ilogb(a), k = -std::ilogb(c);
+    if ((i + k) & 1) ++k;
+    int j = (i + k) / 2;
+    if (std::ilogb(b) + j >= 100) return Roots::Two;                                // b^2 >> 4ac
+    if (std::ilogb(b) + j < -100) return (a > 0) == (c > 0) ? Roots::None : Roots::Two;   // b^2 << 4ac
+    bool certified;
+    double d = compensated(std::scalbn(a, i), std::scalbn(b, j), std::scalbn(c, k), certified);
+    if (certified) return signOf(d);
+    path = Path::Exact;
+    return exactSign(a, b, c);
+}
+
+// a, b, c — конечные
+Discriminant discriminant(double a, double b, double c) {
+    bool certified;
+    double d = compensated(a, b, c, certified);
+    if (certified) return {d, signOf(d), Path::Fast};
+    Path path;
+    Roots kind = rescaledSign(a, b, c, path);
+    return {d, kind, path};
+}
+
+// Прежний способ: сравнение D с eps = 1e-14 (для сравнения в замерах)
+Roots naiveRoots(double a, double b, double c) {
+    double D = b * b - 4.0 * a * c;
+    const double eps = 1e-14;
+    if (D > eps) return Roots::Two;
+    if (std::fabs(D) <= eps) return Roots::One;
+    return Roots::None;
+}
+
+struct Solution {
+    Roots kind;
+    double x1, x2;   // x1 = (-b + sqrt(D)) / 2a, x2 = (-b - sqrt(D)) / 2a
+    Path path;
+};
+
+Solution solveQuadratic(double a, double b, double c) {
+    Discriminant D = discriminant(a, b, c);
+    Solution s{D.kind, 0.0, 0.0, D.path};
+    if (D.kind == Roots::None) return s;
+    if (c == 0.0) {   // x * (a*x + b) = 0
+        double r = -b / a;
+        s.x1 = b >= 0 ? 0.0 : r;
+        s.x2 = b >= 0 ? r : 0.0;
+        return s;
+    }
+    // Корни не меняются от общего множителя 2^t, а замена x = y * 2^k
+    // умножает их ровно на 2^k. При t = -ilogb(c) и k = floor((ilogb(c) -
+    // ilogb(a)) / 2) и a, и c попадают в [1/2, 2), так что ни один из них
+    // не теряется в денормалах; b двигается на 2^(k+t)
+    int ea = std::ilogb(a), ec = std::ilogb(c);
+    int k = (ec - ea - ((ec - ea) & 1)) / 2, t = -ec;
+    if (b != 0.0 && std::ilogb(b) + k + t > 500) {
+        // b^2 больше 4ac в 2^990 раз и более: корни -b/a и -c/b с ошибкой
+        // ниже последнего разряда, а масштабированное b могло бы переполниться
+        double r1 = -b / a, r2 = -c / b;
+        s.x1 = b >= 0 ? r2 : r1;
+        s.x2 = b >= 0 ? r1 : r2;
+        return s;
+    }
+    a = std::scalbn(a, 2 * k + t);
+    b = std::scalbn(b, k + t);
+    c = std::scalbn(c, t);
+    bool certified;
+    double d = compensated(a, b, c, certified);
+    if (D.kind == Roots::One) {
+        s.x1 = s.x2 = std::scalbn(-b / (2.0 * a), k);
+        return s;
+    }
+    // Знак D уже верен; приближённое значение могло выйти <= 0 при D > 0
+    double sqrtD = std::sqrt(std::max(d, 0.0));
+    double q = -0.5 * (b + std::copysign(sqrtD, b));   // без вычитания близких чисел
+    double r1 = std::scalbn(q / a, k), r2 = std::scalbn(q != 0.0 ? c / q : q / a, k);
+    if (!std::signbit(b)) {   // как в copysign: малое b могло стать -0.0
+        s.x1 = r2;
+        s.x2 = r1;
+    } else {
+        s.x1 = r1;
+        s.x2 = r2;
+    }
+    return s;
+}
+
+// ==== Замеры ====
+
+struct Quadratic {
+    double a, b, c;
+};
+
+enum class Workload { Typical, Degenerate, Scaled, Mixed };
+
+// Typical — коэффициенты из [-100, 100]; Degenerate — a*(x - r)^2 с
+// округлёнными коэффициентами, D около нуля любого знака; Scaled —
+// порядки от 1e-300 до 1e300; Mixed — 98% / 1% / 1%
+std::vector<Quadratic> makeWorkload(Workload w, size_t n, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> coef(-100.0, 100.0), unit(1.0, 10.0), root(-10.0, 10.0);
+    std::uniform_int_distribution<int> order(-300, 300);
+    std::vector<Quadratic> v(n);
+    for (Quadratic& q : v) {
+        Workload k = w;
+        if (w == Workload::Mixed) {
+            unsigned x = unsigned(rng() % 100);
+            k = x < 98 ? Workload::Typical : x == 98 ? Workload::Degenerate : Workload::Scaled;
+        }
+        if (k == Workload::Typical) {
+            do q.a = coef(rng); while (q.a == 0.0);
+            q.b = coef(rng);
+            q.c = coef(rng);
+        } else if (k == Workload::Degenerate) {
+            double a = unit(rng), r = root(rng);
+            q = {a, -2.0 * a * r, a * r * r};
+        } else {
+            auto scaled = [&] { return coef(rng) * std::pow(10.0, order(rng)); };
+            do q.a = scaled(); while (q.a == 0.0);
+            q.b = scaled();
+            q.c = scaled();
+        }
+    }
+    return v;
+}
+
+// Выравнивание по числу символов, а не байтов: в UTF-8 русская буква — два байта
+static std::string column(const std::string& text, size_t width, bool left = false) {
+    size_t letters = 0;
+    for (unsigned char ch : text) letters += (ch & 0xC0) != 0x80;
+    std::string pad(letters < width ? width - letters : 1, ' ');
+    return left ? text + pad : pad + text;
+}
+
+static std::string number(double x, int precision) {
+    std::ostringstream o;
+    o << std::fixed << std::setprecision(precision) << x;
+    return o.str();
+}
+
+void runBenchmark(size_t n) {
+    const char* names[] = {"обычные", "почти вырожденные", "плохо масштабированные", "смесь 98/1/1"};
+    std::cout << "Уравнений в наборе: " << n << "\n"
+              << column("набор", 24, true) << column("eps, млн/с", 12) << column("точно, млн/с", 14)
+              << column("масштаб, %", 12) << column("длинная арифм., %", 19) << column("ошибок eps, %", 15) << "\n";
+    for (int w = 0; w < 4; ++w) {
+        std::vector<Quadratic> v = makeWorkload(Workload(w), n, 42 + unsigned(w));
+        std::vector<Roots> naive(n), exact(n);
+        size_t rescaled = 0, escalated = 0, wrong = 0;
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i) naive[i] = naiveRoots(v[i].a, v[i].b, v[i].c);
+        auto t1 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            Discriminant D = discriminant(v[i].a, v[i].b, v[i].c);
+            exact[i] = D.kind;
+            rescaled += D.path == Path::Rescaled;
+            escalated += D.path == Path::Exact;
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < n; ++i) wrong += naive[i] != exact[i];
+        double naiveSec = std::chrono::duration<double>(t1 - t0).count();
+        double exactSec = std::chrono::duration<double>(t2 - t1).count();
+        std::cout << column(names[w], 24, true)
+                  << column(number(n / naiveSec / 1e6, 1), 12) << column(number(n / exactSec / 1e6, 1), 14)
+                  << column(number(100.0 * rescaled / n, 3), 12) << column(number(100.0 * escalated / n, 3), 19) << column(number(100.0 * wrong / n, 3), 15)
+                  << "\n";
+    }
+}
+
+#ifdef DCP_BENCH
+#include "dcp/Bench.h"
+
+static const std::vector<Quadratic>& benchMixed() {
+    static const std::vector<Quadratic> v = makeWorkload(Workload::Mixed, 1 << 16, 42);
+    return v;
+}
+
+BENCH_CASE("quadratic/naive_mixed", [](bench::State& st) {
+    const std::vector<Quadratic>& v = benchMixed();
+    while (st.next())
+        for (const Quadratic& q : v) bench::DoNotOptimize(naiveRoots(q.a, q.b, q.c));
+    st.setItems(double(v.size()));
+});
+
+BENCH_CASE("quadratic/adaptive_mixed", [](bench::State& st) {
+    const std::vector<Quadratic>& v = benchMixed();
+    while (st.next())
+        for (const Quadratic& q : v) bench::DoNotOptimize(discriminant(q.a, q.b, q.c).kind);
+    st.setItems(double(v.size()));
+});
+#else
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        runBenchmark(argc > 2 ? size_t(std::stoull(argv[2])) : 1000000);
+        return 0;
+    }
 
-int main() {
     double a, b, c;
     std::cout << "Введите коэффициенты a, b и c (через пробел): ";
-    if (!(std::cin >> a >> b >> c)) {
+    if (!(std::cin >> a >> b >> c) || !std::isfinite(a) || !std::isfinite(b) || !std::isfinite(c)) {
         std::cerr << "Ошибка ввода\n";
         return 1;
     }
@@ -16,27 +330,25 @@ int main() {
         return 1;
     }
 
-    double D = b * b - 4.0 * a * c;
-    const double eps = 1e-14;  // для сравнения с нулем
+    Solution s = solveQuadratic(a, b, c);
 
-    if (D > eps) {
-        double sqrtD = std::sqrt(D);
-        double x1 = (-b + sqrtD) / (2.0 * a);
-        double x2 = (-b - sqrtD) / (2.0 * a);
+    if (s.kind == Roots::Two) {
         std::cout << std::fixed << std::setprecision(6)
                   << "Два действительных корня:\n"
-                  << "x1 = " << x1 << "\n"
-                  << "x2 = " << x2 << "\n";
+                  << "x1 = " << s.x1 << "\n"
+                  << "x2 = " << s.x2 << "\n";
     }
-    else if (std::fabs(D) <= eps) {
-        double x = -b / (2.0 * a);
+    else if (s.kind == Roots::One) {
         std::cout << std::fixed << std::setprecision(6)
                   << "Один действительный корень:\n"
-                  << "x = " << x << "\n";
+                  << "x = " << s.x1 << "\n";
     }
     else {
         std::cout << "Действительных корней нет\n";
     }
+    if (s.path == Path::Exact)
+        std::cout << "(знак дискриминанта уточнён точной арифметикой)\n";
 
     return 0;
 }
+#endif
@@ -2,15 +2,17 @@
 #include <iostream>
 #include <cmath>
 #include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
-int main() {
-    double x, eps;
-    std::cout << "Введите x (в радианах) и точность (например, 0.00001): ";
-    if (!(std::cin >> x >> eps)) {
-        std::cerr << "Ошибка ввода\n";
-        return 1;
-    }
-
+// Сумма ряда Тейлора для sin(x) до первого члена меньше eps по модулю
+double taylorSin(double x, double eps) {
     // Для лучшей сходимости можно привести x к диапазону [-π, π]
     x = std::fmod(x, 2 * M_PI);
     if (x > M_PI)        x -= 2 * M_PI;
@@ -21,14 +23,284 @@ int main() {
     double x2   = x * x;      // x^2 для ускорения вычислений
     int n = 1;                // индекс очередного члена
 
-    // Генерируем следующий член через предыдущий: 
+    // Генерируем следующий член через предыдущий:
     // term_n = term_{n-1} * ( - x^2 / [(2n)*(2n+1)] )
     while (std::fabs(term) >= eps) {
         term *= - x2 / ((2 * n) * (2 * n + 1));
         sum += term;
         ++n;
     }
+    return sum;
+}
+
+// ==== Табличный синус ====
+//
+// Для массовых расчётов с точностью порядка 1e-7 ряд — лишняя работа.
+// SinTable хранит sin на четверти периода [0, π/2] с шагом, подобранным под
+// допуск, и интерполирует между узлами: линейно (ошибка ≤ h²/8) или
+// кубическим эрмитовым сплайном по sin и cos в узлах (ошибка ≤ h⁴/384).
+// Аргумент приводится к [-π/4, π/4] вычитанием nπ/2 (с FMA — π/2 в двух
+// частях, без неё — в трёх, по Коди–Уэйту; до |x| = 1e8 ошибка приведения
+// ~1e-16, дальше — std::sin), а остальное дают симметрии:
+// sin(r + nπ/2) = ±sin|r| или ±cos r = ±sin(π/2 - |r|).
+// На интервал приходится 2 (линейная) или 4 (кубическая) коэффициента
+// подряд, так что значение — один индекс и одна строка кэша.
+
+class SinTable {
+public:
+    enum class Interp { Linear, Cubic };
+
+    SinTable(double tolerance, Interp mode) : interp(mode) {
+        tolerance = std::max(tolerance, 1e-15);   // ниже — уже округление double
+        double h = mode == Interp::Linear ? std::sqrt(8.0 * tolerance)
+                                          : std::pow(384.0 * tolerance, 0.25);
+        n = std::max(1, int(std::ceil(kHalfPi / h)));
+        h = kHalfPi / n;
+        invStep = n / kHalfPi;
+        stride = mode == Interp::Linear ? 2 : 4;
+        // Лишний интервал в конце: u = π/2 с учётом округления не выйдет за таблицу
+        coef.assign(size_t(n + 1) * stride, 0.0);
+        for (int k = 0; k <= n; ++k) {
+            double y0 = std::sin(k * h), y1 = std::sin((k + 1) * h);
+            double* c = &coef[size_t(k) * stride];
+            if (mode == Interp::Linear) {
+                c[0] = y0;
+                c[1] = y1 - y0;
+            } else {
+                // p(t) = c0 + t(c1 + t(c2 + t c3)), t ∈ [0, 1]
+                double d0 = h * std::cos(k * h), d1 = h * std::cos((k + 1) * h);
+                c[0] = y0;
+                c[1] = d0;
+                c[2] = 3.0 * (y1 - y0) - 2.0 * d0 - d1;
+                c[3] = 2.0 * (y0 - y1) + d0 + d1;
+            }
+        }
+    }
+
+    int intervals() const { return n; }
+    size_t bytes() const { return coef.size() * sizeof(double); }
+
+    double sin(double x) const { return eval(x, 0); }
+    double cos(double x) const { return eval(x, 1); }
+
+    // out[i] = sin(x[i]); x и out могут совпадать
+    void sin(const double* x, double* out, size_t count) const { evalMany(x, out, count, 0); }
+    void cos(const double* x, double* out, size_t count) const { evalMany(x, out, count, 1); }
+
+private:
+    static constexpr double kHalfPi = 1.57079632679489661923;
+    static constexpr double kTwoOverPi = 0.63661977236758134308;
+    // Без FMA: π/2 = kPi2Hi + kPi2Mid + kPi2Lo; в первых двух не больше 27
+    // значащих битов, так что q·kPi2Hi и q·kPi2Mid точны при |q| < 2^26, то
+    // есть для всех |x| ≤ kMaxArg, и x - q·kPi2Hi тоже точно (числа близки).
+    // С FMA произведение не округляется и хватает π/2 = kHalfPi + kHalfPiTail
+    static constexpr double kHalfPiTail = 0x1.1a62633145c07p-54;
+    static constexpr double kPi2Hi = 0x1.921fb54p+0;
+    static constexpr double kPi2Mid = 0x1.10b461p-30;
+    static constexpr double kPi2Lo = 0x1.a62633145c06ep-58;
+    static constexpr double kMaxArg = 1e8;
+    static constexpr double kRound = 6755399441055744.0;     // 1.5·2^52
+
+    Interp interp;
+    int n = 0;
+    int stride = 2;
+    double invStep = 0;
+    std::vector<double> coef;
+
+    // sin(x + shift·π/2)
+    double eval(double x, int shift) const {
+        if (!(std::fabs(x) <= kMaxArg)) return shift ? std::cos(x) : std::sin(x);
+        // Округление до целого сложением с 1.5·2^52: быстрее nearbyint без SSE4.1
+        double q = (x * kTwoOverPi + kRound) - kRound;
+#ifdef FP_FAST_FMA
+        double r = std::fma(-q, kHalfPiTail, std::fma(-q, kHalfPi, x));
+#else
+        double r = ((x - q * kPi2Hi) - q * kPi2Mid) - q * kPi2Lo;
+#endif
+        long long quadrant = (long long)q + shift;
+        bool odd = quadrant & 1;
+        double a = std::fabs(r);
+        double u = odd ? kHalfPi - a : a;
+        // Минус во 2-й и 3-й четвертях, плюс знак r там, где берётся sin|r|
+        double sign = double(1 - (quadrant & 2));
+        sign = odd ? sign : std::copysign(sign, sign * r);
+        double t = u * invStep;
+        int k = std::min(int(t), n);
+        t -= k;
+        const double* c = &coef[size_t(k) * stride];
+        double y = interp == Interp::Linear ? c[0] + t * c[1]
+                                            : c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+        return sign * y;
+    }
+
+    void evalMany(const double* x, double* out, size_t count, int shift) const {
+        size_t i = 0;
+#if defined(__AVX2__)
+#if defined(__FMA__)
+        const __m256d tail = _mm256_set1_pd(kHalfPiTail);
+#else
+        const __m256d hi = _mm256_set1_pd(kPi2Hi), mid = _mm256_set1_pd(kPi2Mid), lo = _mm256_set1_pd(kPi2Lo);
+#endif
+        const __m256d twoOverPi = _mm256_set1_pd(kTwoOverPi), halfPi = _mm256_set1_pd(kHalfPi),
+                      inv = _mm256_set1_pd(invStep), maxArg = _mm256_set1_pd(kMaxArg),
+                      signBit = _mm256_set1_pd(-0.0);
+        const __m128i shiftV = _mm_set1_epi32(shift), last = _mm_set1_epi32(n),
+                      one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+        const double* base = coef.data();
+        // Маскированная выборка с явным нулевым источником: то же, что
+        // _mm256_i32gather_pd, но GCC не ругается на неинициализированный регистр
+        const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), zero = _mm256_setzero_pd();
+        auto gather = [&](int offset, __m128i idx) {
+            return _mm256_mask_i32gather_pd(zero, base + offset, idx, all, 8);
+        };
+        for (; i + 4 <= count; i += 4) {
+            __m256d v = _mm256_loadu_pd(x + i);
+            __m256d q = _mm256_round_pd(_mm256_mul_pd(v, twoOverPi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+#if defined(__FMA__)
+            __m256d r = _mm256_fnmadd_pd(q, tail, _mm256_fnmadd_pd(q, halfPi, v));
+#else
+            __m256d r = _mm256_sub_pd(v, _mm256_mul_pd(q, hi));
+            r = _mm256_sub_pd(_mm256_sub_pd(r, _mm256_mul_pd(q, mid)), _mm256_mul_pd(q, lo));
+#endif
+            __m128i quadrant = _mm_add_epi32(_mm256_cvtpd_epi32(q), shiftV);
+            __m256d a = _mm256_andnot_pd(signBit, r);
+            // Маски чётности и знака четверти — из 32-битных в 64-битные дорожки
+            __m256d odd = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(
+                _mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one)));
+            __m256d negQ = _mm256_castsi256_pd(_mm256_slli_epi64(
+                _mm256_cvtepi32_epi64(_mm_srli_epi32(_mm_and_si128(quadrant, two), 1)), 63));
+            __m256d u = _mm256_blendv_pd(a, _mm256_sub_pd(halfPi, a), odd);
+            // Знак: минус во 2-й и 3-й четвертях, плюс знак r там, где берётся sin|r|
+            __m256d sign = _mm256_xor_pd(negQ, _mm256_andnot_pd(odd, _mm256_and_pd(r, signBit)));
+
+            __m256d t = _mm256_mul_pd(u, inv);
+            __m128i k = _mm_min_epi32(_mm256_cvttpd_epi32(t), last);
+            t = _mm256_sub_pd(t, _mm256_cvtepi32_pd(k));
+            __m256d y;
+            if (interp == Interp::Linear) {
+                __m128i idx = _mm_slli_epi32(k, 1);
+                __m256d c0 = gather(0, idx);
+                __m256d c1 = gather(1, idx);
+                y = _mm256_add_pd(c0, _mm256_mul_pd(t, c1));
+            } else {
+                __m128i idx = _mm_slli_epi32(k, 2);
+                __m256d c0 = gather(0, idx);
+                __m256d c1 = gather(1, idx);
+                __m256d c2 = gather(2, idx);
+                __m256d c3 = gather(3, idx);
+                y = _mm256_add_pd(c2, _mm256_mul_pd(t, c3));
+                y = _mm256_add_pd(c1, _mm256_mul_pd(t, y));
+                y = _mm256_add_pd(c0, _mm256_mul_pd(t, y));
+            }
+            // Большие аргументы и NaN — редкость, досчитываем их по одному
+            // (аргументы сохраняются заранее: out может совпадать с x)
+            int far = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_andnot_pd(signBit, v), maxArg, _CMP_NLE_UQ));
+            double arg[4];
+            if (far) _mm256_storeu_pd(arg, v);
+            _mm256_storeu_pd(out + i, _mm256_xor_pd(y, sign));
+            if (far)
+                for (int l = 0; l < 4; ++l)
+                    if (far >> l & 1) out[i + l] = eval(arg[l], shift);
+        }
+#endif
+        for (; i < count; ++i) out[i] = eval(x[i], shift);
+    }
+};
+
+// Таблица скоростей и максимальных ошибок против std::sin для нескольких допусков
+void runTableBenchmark(size_t count) {
+    std::mt19937_64 rng(1);
+    std::uniform_real_distribution<double> angle(-100.0, 100.0);
+    std::vector<double> x(count), ref(count), y(count);
+    for (double& v : x) v = angle(rng);
+
+    auto rate = [&](auto&& fn) {
+        fn();   // прогрев
+        auto t0 = std::chrono::steady_clock::now();
+        int reps = 0;
+        double sec;
+        do {
+            fn();
+            ++reps;
+            sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        } while (sec < 0.2);
+        return double(count) * reps / sec / 1e6;
+    };
+
+    double libRate = rate([&] { for (size_t i = 0; i < count; ++i) ref[i] = std::sin(x[i]); });
+    double taylorRate = rate([&] { for (size_t i = 0; i < count; ++i) y[i] = taylorSin(x[i], 1e-7); });
+    std::cout << "Углов: " << count << " из [-100, 100], млн значений/с\n"
+              << std::fixed << std::setprecision(1)
+              << "  std::sin            " << std::setw(8) << libRate << "\n"
+              << "  ряд Тейлора (1e-7)  " << std::setw(8) << taylorRate << "\n\n"
+              << "  интерполяция  допуск  интервалов     байт  поштучно  пакетом  макс. ошибка\n";
+    for (SinTable::Interp mode : {SinTable::Interp::Linear, SinTable::Interp::Cubic})
+        for (double tol : {1e-4, 1e-5, 1e-7, 1e-9, 1e-12}) {
+            SinTable table(tol, mode);
+            double one = rate([&] { for (size_t i = 0; i < count; ++i) y[i] = table.sin(x[i]); });
+            double batch = rate([&] { table.sin(x.data(), y.data(), count); });
+            double err = 0;
+            for (size_t i = 0; i < count; ++i) err = std::max(err, std::fabs(y[i] - ref[i]));
+            std::cout << (mode == SinTable::Interp::Linear ? "  линейная    " : "  кубическая  ")
+                      << std::scientific << std::setprecision(0) << std::setw(7) << tol
+                      << std::setw(12) << table.intervals() << std::setw(9) << table.bytes()
+                      << std::fixed << std::setprecision(1) << std::setw(10) << one << std::setw(9) << batch
+                      << std::scientific << std::setprecision(2) << std::setw(14) << err << "\n";
+        }
+}
+
+#ifdef DCP_BENCH
+#include "dcp/Bench.h"
+
+// 1024 точки на [-10, 10], одна итерация — все точки
+static double sinPoint(int i) { return -10.0 + 20.0 * i / 1024; }
+
+BENCH_CASE("sin/taylor_1e-10", [](bench::State& st) {
+    while (st.next())
+        for (int i = 0; i < 1024; ++i) bench::DoNotOptimize(taylorSin(sinPoint(i), 1e-10));
+    st.setItems(1024);
+});
+
+BENCH_CASE("sin/std", [](bench::State& st) {
+    while (st.next())
+        for (int i = 0; i < 1024; ++i) {
+            double x = sinPoint(i);
+            bench::DoNotOptimize(x);
+            bench::DoNotOptimize(std::sin(x));
+        }
+    st.setItems(1024);
+});
+
+// Табличный синус пакетом по тем же точкам
+static void tableCase(bench::State& st, SinTable::Interp mode) {
+    SinTable table(1e-7, mode);
+    std::vector<double> x(1024), y(1024);
+    for (int i = 0; i < 1024; ++i) x[size_t(i)] = sinPoint(i);
+    while (st.next()) {
+        table.sin(x.data(), y.data(), x.size());
+        bench::ClobberMemory();
+    }
+    st.setItems(1024);
+}
+
+BENCH_CASE("sin/table_linear_1e-7", [](bench::State& st) { tableCase(st, SinTable::Interp::Linear); });
+BENCH_CASE("sin/table_cubic_1e-7", [](bench::State& st) { tableCase(st, SinTable::Interp::Cubic); });
+#else
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--table") == 0) {
+        runTableBenchmark(argc > 2 ? size_t(std::stoull(argv[2])) : 1 << 16);
+        return 0;
+    }
+
+    double x, eps;
+    std::cout << "Введите x (в радианах) и точность (например, 0.00001): ";
+    if (!(std::cin >> x >> eps)) {
+        std::cerr << "Ошибка ввода\n";
+        return 1;
+    }
 
+    double sum = taylorSin(x, eps);
     double lib_sin = std::sin(x);
 
     std::cout << std::fixed << std::setprecision(10)
@@ -38,3 +310,4 @@ int main() {
 
     return 0;
 }
+#endif
@@ -1,197 +1,137 @@
 #include <iostream>
 #include <string>
-#include <list>
-#include <vector>
-#include <algorithm>
-#include <cctype>
-#include <stdexcept>
-#include <iomanip>
-
-static const uint32_t BASE = 1000000000; // 10^9
-
-// Класс для работы с большими неотрицательными числами
-class BigInt {
-public:
-    // младший чанк — в front(), старший — в back()
-    std::list<uint32_t> chunks;
-    bool negative = false;
-
-    BigInt() = default;
-
-    // Парсинг из строки (только цифры, до 200 символов)
-    static BigInt fromString(const std::string &s) {
-        if (s.empty() || s.size() > 200)
-            throw std::invalid_argument("Неверная длина числа");
-        for (char c : s)
-            if (!std::isdigit(c))
-                throw std::invalid_argument("Неверный символ в числе");
-
-        BigInt R;
-        int len = int(s.size());
-        for (int i = len; i > 0; i -= 9) {
-            int start = std::max(0, i - 9);
-            int count = i - start;
-            uint32_t chunk = std::stoul(s.substr(start, count));
-            R.chunks.push_back(chunk);
-        }
-        R.trim();
-        return R;
-    }
+#include <chrono>
+#include <cstring>
+#include <random>
+#include "BigInt.h"
+
+// Случайное число из digits цифр (без ведущего нуля)
+static std::string randomDigits(size_t digits, std::mt19937& rng) {
+    std::string s(digits, '0');
+    for (char& c : s) c = char('0' + rng() % 10);
+    s[0] = char('1' + rng() % 9);
+    return s;
+}
 
-    // Удаляем ведущие нулевые чанки (верхний край), оставляем хотя бы один
-    void trim() {
-        while (chunks.size() > 1 && chunks.back() == 0)
-            chunks.pop_back();
-        if (chunks.size() == 1 && chunks.front() == 0)
-            negative = false;
-    }
+static std::string randomDigits(size_t digits, unsigned seed) {
+    std::mt19937 rng(seed);
+    return randomDigits(digits, rng);
+}
 
-    // Сравнение по абсолютному значению
-    static int cmpAbs(const BigInt &A, const BigInt &B) {
-        if (A.chunks.size() != B.chunks.size())
-            return A.chunks.size() < B.chunks.size() ? -1 : +1;
-        // одинаковая длина — сравниваем от старшего чанка
-        auto a_it = A.chunks.rbegin();
-        auto b_it = B.chunks.rbegin();
-        while (a_it != A.chunks.rend()) {
-            if (*a_it != *b_it)
-                return *a_it < *b_it ? -1 : +1;
-            ++a_it; ++b_it;
-        }
-        return 0;
+// n случайных чисел из digits цифр со случайными знаками. Цифры и знаки
+// берутся из одного генератора, так что наборы с разными seed не пересекаются.
+static std::vector<BigInt> randomNumbers(size_t n, size_t digits, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<BigInt> v;
+    v.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        v.push_back(BigInt::fromString(randomDigits(digits, rng)));
+        v.back().negative = rng() % 2 == 0;
     }
+    return v;
+}
 
-    // Сложение абсолютных значений
-    static BigInt addAbs(const BigInt &A, const BigInt &B) {
-        BigInt R;
-        auto itA = A.chunks.begin();
-        auto itB = B.chunks.begin();
-        uint64_t carry = 0;
-        while (itA != A.chunks.end() || itB != B.chunks.end() || carry) {
-            uint64_t a = (itA != A.chunks.end() ? *itA++ : 0);
-            uint64_t b = (itB != B.chunks.end() ? *itB++ : 0);
-            uint64_t sum = a + b + carry;
-            R.chunks.push_back(uint32_t(sum % BASE));
-            carry = sum / BASE;
-        }
-        return R;
-    }
+// ==== Замеры (запуск: Z5 --bench) ====
 
-    // Вычитание абсолютных значений: предполагаем A >= B
-    static BigInt subAbs(const BigInt &A, const BigInt &B) {
-        BigInt R;
-        auto itA = A.chunks.begin();
-        auto itB = B.chunks.begin();
-        int64_t borrow = 0;
-        while (itA != A.chunks.end()) {
-            int64_t a = int64_t(*itA++) - borrow;
-            int64_t b = (itB != B.chunks.end() ? *itB++ : 0);
-            if (a < b) {
-                a += BASE;
-                borrow = 1;
-            } else {
-                borrow = 0;
-            }
-            R.chunks.push_back(uint32_t(a - b));
-        }
-        R.trim();
-        return R;
-    }
+static double secondsSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
 
-    // Операция сложения с учётом знака
-    BigInt operator+(const BigInt &other) const {
-        if (negative == other.negative) {
-            BigInt R = addAbs(*this, other);
-            R.negative = negative;
-            R.trim();
-            return R;
-        } else {
-            // A + (-B) = A - B
-            if (cmpAbs(*this, other) >= 0) {
-                BigInt R = subAbs(*this, other);
-                R.negative = negative;
-                R.trim();
-                return R;
-            } else {
-                BigInt R = subAbs(other, *this);
-                R.negative = other.negative;
-                R.trim();
-                return R;
-            }
-        }
+// Сумма произведений и многочлен: цепочка операторов против накопителя
+void runBenchmark() {
+    std::cout << "Скалярное произведение, числа по 36 цифр:\n"
+              << "  слагаемых    acc = acc + a*b, мс    dot, мс    ускорение\n";
+    for (size_t n = 1000; n <= 1000000; n *= 10) {
+        std::vector<BigInt> a = randomNumbers(n, 36, 1), b = randomNumbers(n, 36, 2);
+        auto t0 = std::chrono::steady_clock::now();
+        BigInt naive = BigInt::fromU64(0);
+        for (size_t i = 0; i < n; ++i) naive = naive + a[i] * b[i];
+        double tNaive = secondsSince(t0);
+        t0 = std::chrono::steady_clock::now();
+        BigInt fused = dot(a, b);
+        double tFused = secondsSince(t0);
+        std::cout << "  " << std::setw(9) << n << std::setw(22) << tNaive * 1e3 << std::setw(11) << tFused * 1e3
+                  << std::setw(12) << tNaive / tFused
+                  << (naive.toString() == fused.toString() ? "" : "  РАСХОЖДЕНИЕ!") << "\n";
     }
 
-    // Вычитание с учётом знака
-    BigInt operator-(const BigInt &other) const {
-        if (negative != other.negative) {
-            // A - (-B) = A + B
-            BigInt R = addAbs(*this, other);
-            R.negative = negative;
-            R.trim();
-            return R;
-        } else {
-            // A - B = ?
-            if (cmpAbs(*this, other) >= 0) {
-                BigInt R = subAbs(*this, other);
-                R.negative = negative;
-                R.trim();
-                return R;
-            } else {
-                BigInt R = subAbs(other, *this);
-                R.negative = !negative;
-                R.trim();
-                return R;
-            }
-        }
+    std::cout << "Многочлен, коэффициенты и x по 18 цифр:\n"
+              << "  степень    Горнер, мс    polynomial, мс    ускорение\n";
+    for (size_t n : {100, 1000, 3000}) {
+        std::vector<BigInt> c = randomNumbers(n, 18, 3);
+        BigInt x = BigInt::fromString(randomDigits(18, 99));
+        auto t0 = std::chrono::steady_clock::now();
+        BigInt naive = BigInt::fromU64(0);
+        for (size_t i = n; i-- > 0;) naive = naive * x + c[i];
+        double tNaive = secondsSince(t0);
+        t0 = std::chrono::steady_clock::now();
+        BigInt fused = polynomial(c, x);
+        double tFused = secondsSince(t0);
+        std::cout << "  " << std::setw(7) << n << std::setw(14) << tNaive * 1e3 << std::setw(18) << tFused * 1e3
+                  << std::setw(13) << tNaive / tFused
+                  << (naive.toString() == fused.toString() ? "" : "  РАСХОЖДЕНИЕ!") << "\n";
     }
+}
 
-    // Умножение методом «столбиком»
-    BigInt operator*(const BigInt &other) const {
-        // переводим в вектор для удобного индексирования
-        std::vector<uint64_t> a(chunks.begin(), chunks.end());
-        std::vector<uint64_t> b(other.chunks.begin(), other.chunks.end());
-        std::vector<uint64_t> res(a.size() + b.size(), 0);
-
-        for (size_t i = 0; i < a.size(); ++i) {
-            uint64_t carry = 0;
-            for (size_t j = 0; j < b.size() || carry; ++j) {
-                uint64_t cur = res[i + j] +
-                    a[i] * (j < b.size() ? b[j] : 0) +
-                    carry;
-                res[i + j] = cur % BASE;
-                carry = cur / BASE;
-            }
+#ifdef DCP_BENCH
+#include "dcp/Bench.h"
+
+BENCH_CASE("bigint/parse_200", [](bench::State& st) {
+    std::string s = randomDigits(200, 1);
+    while (st.next()) bench::DoNotOptimize(BigInt::fromString(s));
+    st.setBytes(200);
+});
+
+BENCH_CASE("bigint/add_200", [](bench::State& st) {
+    BigInt a = BigInt::fromString(randomDigits(200, 1));
+    BigInt b = BigInt::fromString(randomDigits(200, 2));
+    while (st.next()) bench::DoNotOptimize(a + b);
+    st.setItems(1);
+});
+
+BENCH_CASE("bigint/sub_200", [](bench::State& st) {
+    BigInt a = BigInt::fromString(randomDigits(200, 1));
+    BigInt b = BigInt::fromString(randomDigits(200, 2));
+    while (st.next()) bench::DoNotOptimize(a - b);
+    st.setItems(1);
+});
+
+BENCH_CASE("bigint/mul_200", [](bench::State& st) {
+    BigInt a = BigInt::fromString(randomDigits(200, 1));
+    BigInt b = BigInt::fromString(randomDigits(200, 2));
+    while (st.next()) bench::DoNotOptimize(a * b);
+    st.setItems(1);
+});
+
+BENCH_CASE("bigint/to_string_400", [](bench::State& st) {
+    BigInt p = BigInt::fromString(randomDigits(200, 1)) * BigInt::fromString(randomDigits(200, 2));
+    while (st.next()) bench::DoNotOptimize(p.toString());
+    st.setBytes(400);
+});
+
+static void dotCase(bench::State& st, bool fused) {
+    std::vector<BigInt> a = randomNumbers(1000, 36, 1), b = randomNumbers(1000, 36, 2);
+    while (st.next()) {
+        if (fused) {
+            bench::DoNotOptimize(dot(a, b));
+            continue;
         }
-        BigInt R;
-        R.negative = (negative != other.negative);
-        // переносим ненулевые части в список
-        size_t k = res.size();
-        while (k > 1 && res[k-1] == 0) --k;
-        for (size_t i = 0; i < k; ++i)
-            R.chunks.push_back(uint32_t(res[i]));
-        R.trim();
-        return R;
+        BigInt acc = BigInt::fromU64(0);
+        for (size_t i = 0; i < a.size(); ++i) acc = acc + a[i] * b[i];
+        bench::DoNotOptimize(acc);
     }
+    st.setItems(1000);
+}
 
-    // Преобразование обратно в десятичную строку
-    std::string toString() const {
-        if (chunks.empty()) return "0";
-        std::string s;
-        if (negative) s.push_back('-');
-        // самый старший чанк без ведущих нулей
-        auto it = chunks.rbegin();
-        s += std::to_string(*it++);
-        // остальные — ровно 9 цифр с ведущими нулями
-        for (; it != chunks.rend(); ++it) {
-            std::ostringstream oss;
-            oss << std::setw(9) << std::setfill('0') << *it;
-            s += oss.str();
-        }
-        return s;
-    }
-};
+BENCH_CASE("bigint/dot_naive_1000", [](bench::State& st) { dotCase(st, false); });
+BENCH_CASE("bigint/dot_fused_1000", [](bench::State& st) { dotCase(st, true); });
+#else
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        runBenchmark();
+        return 0;
+    }
     try {
         std::string sa, sb;
         std::cout << "Введите два неотрицательных целых числа (до 200 цифр) через пробел:\n> ";
@@ -217,3 +157,4 @@ int main() {
     }
     return 0;
 }
+#endif
@@ -1,291 +1,3062 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <limits>
 #include <algorithm>  // std::swap
+#include <vector>
+#include <list>
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <cstdint>
+#include <cmath>
+#include <cctype>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <cstring>
+#include <cstdio>      // std::remove
+#include <charconv>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>     // _BitScanForward64
+#endif
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>    // FlushFileBuffers
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>      // open, fsync — сброс на диск перед подменой файла
+#include <unistd.h>
+#endif
 
-// Узловой элемент списка — книга
+#include "dcp/Bench.h"  // bench::DoNotOptimize; случаи BENCH_CASE — только с -DDCP_BENCH
+
+// Строка-поле книги. Короткая (до kInline байт) хранится прямо в узле,
+// длинная — в текстовой арене пула списка. Копируется побайтно и не
+// требует деструктора, поэтому узлы можно освобождать целыми блоками.
+class BookStr {
+public:
+    static const size_t kInline = 23;
+
+    BookStr() { raw[kInline] = 0; }
+
+    void setInline(std::string_view s) {
+        std::memcpy(raw, s.data(), s.size());
+        raw[kInline] = char(s.size());
+    }
+
+    void setExternal(const char* p, uint32_t n) {
+        std::memcpy(raw, &p, sizeof(p));
+        std::memcpy(raw + sizeof(p), &n, sizeof(n));
+        raw[kInline] = char(kLong);
+    }
+
+    bool isInline() const { return (unsigned char)raw[kInline] != kLong; }
+
+    const char* data() const {
+        if (isInline()) return raw;
+        const char* p;
+        std::memcpy(&p, raw, sizeof(p));
+        return p;
+    }
+
+    size_t size() const {
+        if (isInline()) return (unsigned char)raw[kInline];
+        uint32_t n;
+        std::memcpy(&n, raw + sizeof(const char*), sizeof(n));
+        return n;
+    }
+
+    operator std::string_view() const { return std::string_view(data(), size()); }
+    std::string str() const { return std::string(data(), size()); }
+
+private:
+    static const unsigned char kLong = 0xFF;
+    alignas(8) char raw[kInline + 1];
+};
+
+inline bool operator==(const BookStr& a, std::string_view b) { return std::string_view(a) == b; }
+inline bool operator!=(const BookStr& a, std::string_view b) { return !(a == b); }
+inline bool operator==(const BookStr& a, const BookStr& b) { return std::string_view(a) == std::string_view(b); }
+inline bool operator<(const BookStr& a, const BookStr& b)  { return std::string_view(a) < std::string_view(b); }
+inline bool operator>(const BookStr& a, const BookStr& b)  { return b < a; }
+inline std::ostream& operator<<(std::ostream& out, const BookStr& s) { return out << std::string_view(s); }
+
+// Узловой элемент списка — книга (создаётся через newBook из пула списка)
 struct BookNode {
-    std::string title;
-    std::string author;
+    BookStr title;
+    BookStr author;
     int year;
-    std::string publisher;
+    uint32_t id;          // номер в реестре BookList::byId
+    BookStr publisher;
     int pages;
     BookNode* next;
-    BookNode(const std::string& t, const std::string& a, int y,
-             const std::string& pub, int p)
-      : title(t), author(a), year(y),
-        publisher(pub), pages(p), next(nullptr) {}
+    uint64_t seq;         // место в списке: растёт от головы к хвосту (см. assignSeq)
+};
+
+const size_t kSlabNodes = 4096;      // узлов в одном блоке пула
+const size_t kTextSlab  = 1 << 20;   // байт в одном блоке текстовой арены
+
+// Пул узлов: узлы нарезаются из блоков подряд в порядке создания,
+// удалённые уходят в список свободных. Длинные строки живут в арене
+// до очистки списка. Всё освобождается разом вместе с пулом.
+struct NodePool {
+    std::vector<std::unique_ptr<BookNode[]>> slabs;
+    size_t used = kSlabNodes;        // занято в последнем блоке
+    BookNode* freeList = nullptr;    // связаны через next
+    std::vector<std::unique_ptr<char[]>> text;
+    size_t textUsed = 0;
+    size_t textCap = 0;              // размер последнего текстового блока
+};
+
+// Список id одной триграммы: дельты в varint + точки пропуска
+struct PostingSkip {
+    uint32_t id;      // id элемента с номером k * kSkipStep
+    uint32_t offset;  // смещение varint следующего за ним элемента
+    uint32_t rank;    // ранг этого элемента
+};
+
+struct Postings {
+    std::vector<uint8_t> bytes;
+    std::vector<PostingSkip> skips;
+    uint32_t last = 0;
+    uint32_t count = 0;
+};
+
+// Индекс заголовков: триграммы для подстрок, отсортированные id для префиксов.
+// Строится лениво при первом запросе, дальше обновляется на add/remove.
+struct TitleIndex {
+    bool built = false;
+    std::unordered_map<uint32_t, Postings> grams;
+    std::string text;                  // заголовки в нижнем регистре подряд
+    std::vector<uint32_t> offset;      // id → начало в text; offset[id + 1] — конец
+    std::vector<uint8_t> alive;        // id → 1, если книга ещё в списке
+    std::vector<uint32_t> sortedIds;   // id по возрастанию folded(id), равные — по seq
+    std::vector<uint32_t> pendingIds;  // добавлены после сборки, ещё не слиты
+    size_t liveCount = 0;
+    size_t deadCount = 0;
+
+    std::string_view folded(uint32_t id) const {
+        return std::string_view(text).substr(offset[id], offset[id + 1] - offset[id]);
+    }
+};
+
+// Сводка по блоку из kYearBlock подряд идущих записей индекса годов
+struct YearBlock {
+    int minYear;
+    int maxYear;
+    uint32_t count;
+    int64_t pages;
+    std::vector<std::pair<uint32_t, uint32_t>> authors;   // (номер автора, книг), по номеру
+};
+
+// Индекс по году: столбцы, упорядоченные по (год, id), и сводки блоков.
+// Пересобирается, если каталог изменился с момента сборки.
+struct YearIndex {
+    uint64_t version = UINT64_MAX;       // версия каталога при сборке
+    std::vector<int> years;
+    std::vector<int> pages;
+    std::vector<uint32_t> ids;
+    std::vector<uint32_t> authorOf;      // номер автора в authorNames
+    std::vector<std::string> authorNames;
+    std::vector<YearBlock> blocks;
+};
+
+const size_t kQueryCacheBytes = 16 << 20;   // предел кэша запросов
+const size_t kQueryEntryOverhead = 96;      // узлы списка и таблицы, заголовки строк
+
+// Кэш запросов по автору и году: ключ — вид запроса и аргумент, значение —
+// id найденных книг в порядке выдачи. Записи верны для одной версии
+// каталога; сверх предела вытесняются давно не запрошенные.
+struct QueryCache {
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const std::vector<uint32_t>> ids;
+        size_t bytes;
+    };
+    uint64_t version = UINT64_MAX;   // версия каталога, для которой верны записи
+    std::list<Entry> lru;            // недавно запрошенные — в начале
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> byKey;   // ключи — из Entry::key
+    size_t bytes = 0;
+    size_t limit = kQueryCacheBytes;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t invalidations = 0;      // сбросов из-за изменения каталога
+};
+
+// Сохранение, идущее в фоне. Пока оно не закончено, узлы из снимка
+// не переиспользуются, а пулы, сброшенные clearList, не освобождаются.
+struct AsyncSave {
+    std::thread worker;
+    std::string filename;
+    std::vector<const BookNode*> nodes;   // снимок: узлы в порядке списка
+    std::atomic<size_t> written{0};       // книг уже записано
+    std::atomic<bool> done{false};
+    bool ok = false;
+    std::vector<BookNode*> deferred;      // удалены во время сохранения
+    std::vector<NodePool> retired;        // сброшены во время сохранения
+
+    ~AsyncSave() { if (worker.joinable()) worker.join(); }
+};
+
+// Головной элемент списка
+struct BookList {
+    BookNode* head;
+    BookNode* tail;
+    size_t count;
+    uint64_t version;              // растёт при любом изменении каталога
+    std::vector<BookNode*> byId;   // id → узел (nullptr после удаления)
+    TitleIndex titles;
+    YearIndex years;
+    QueryCache queries;
+    NodePool pool;
+    std::unique_ptr<AsyncSave> saving;   // последним: разрушается первым и ждёт запись
+    BookList() : head(nullptr), tail(nullptr), count(0), version(0) {}
+};
+
+// Вспомогательный ввод целого числа
+int readInt(const std::string& prompt) {
+    int x;
+    while (true) {
+        std::cout << prompt;
+        if (std::cin >> x) {
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            return x;
+        }
+        std::cout << "Неверный ввод, попробуйте ещё раз.\n";
+        std::cin.clear();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+}
+
+// ==== Пул узлов ====
+
+BookNode* allocNode(NodePool& P) {
+    if (BookNode* n = P.freeList) {
+        P.freeList = n->next;
+        return n;
+    }
+    if (P.used == kSlabNodes) {
+        P.slabs.emplace_back(new BookNode[kSlabNodes]);
+        P.used = 0;
+    }
+    return &P.slabs.back()[P.used++];
+}
+
+const char* storeText(NodePool& P, std::string_view s) {
+    if (P.textCap - P.textUsed < s.size()) {
+        P.textCap = std::max(kTextSlab, s.size());
+        P.text.emplace_back(new char[P.textCap]);
+        P.textUsed = 0;
+    }
+    char* dst = P.text.back().get() + P.textUsed;
+    std::memcpy(dst, s.data(), s.size());
+    P.textUsed += s.size();
+    return dst;
+}
+
+void setField(NodePool& P, BookStr& field, std::string_view s) {
+    if (s.size() <= BookStr::kInline) field.setInline(s);
+    else field.setExternal(storeText(P, s), uint32_t(s.size()));
+}
+
+// Новый узел из пула P (в список ещё не вставлен)
+BookNode* makeBook(NodePool& P, std::string_view t, std::string_view a, int y,
+                   std::string_view pub, int p) {
+    BookNode* n = allocNode(P);
+    setField(P, n->title, t);
+    setField(P, n->author, a);
+    n->year = y;
+    setField(P, n->publisher, pub);
+    n->pages = p;
+    n->next = nullptr;
+    n->id = 0;
+    n->seq = 0;
+    return n;
+}
+
+BookNode* newBook(BookList& L, std::string_view t, std::string_view a, int y,
+                  std::string_view pub, int p) {
+    return makeBook(L.pool, t, a, y, pub, p);
+}
+
+// Перенести блоки пула src в конец dst. Узлы и строки остаются на месте,
+// поэтому указатели на них не меняются.
+void splicePool(NodePool& dst, NodePool&& src) {
+    if (!src.slabs.empty()) {
+        for (auto& s : src.slabs) dst.slabs.push_back(std::move(s));
+        dst.used = src.used;
+    }
+    if (!src.text.empty()) {
+        for (auto& t : src.text) dst.text.push_back(std::move(t));
+        dst.textUsed = src.textUsed;
+        dst.textCap = src.textCap;
+    }
+    while (BookNode* n = src.freeList) {
+        src.freeList = n->next;
+        n->next = dst.freeList;
+        dst.freeList = n;
+    }
+    src = NodePool();
+}
+
+// Вернуть узел в пул (его длинные строки остаются в арене до очистки).
+// Во время фонового сохранения узел может быть в снимке — вернём его позже.
+void freeBook(BookList& L, BookNode* n) {
+    if (L.saving) {
+        L.saving->deferred.push_back(n);
+        return;
+    }
+    n->next = L.pool.freeList;
+    L.pool.freeList = n;
+}
+
+// ==== Индекс заголовков ====
+
+const uint32_t kSkipStep = 128;        // шаг точек пропуска в списках id
+const size_t   kPendingLimit = 4096;   // сколько новых id держим вне sortedIds
+
+// Нижний регистр для ASCII и кириллицы в UTF-8 (А–Я, Ё)
+std::string foldTitle(std::string_view s) {
+    std::string r;
+    r.reserve(s.size());
+    for (size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = s[i];
+        if (c >= 'A' && c <= 'Z') {
+            r.push_back(char(c - 'A' + 'a'));
+        } else if (c == 0xD0 && i + 1 < s.size()) {
+            unsigned char d = s[++i];
+            if (d >= 0x90 && d <= 0x9F)      { r.push_back(char(0xD0)); r.push_back(char(d + 0x20)); }
+            else if (d >= 0xA0 && d <= 0xAF) { r.push_back(char(0xD1)); r.push_back(char(d - 0x20)); }
+            else if (d == 0x81)              { r.push_back(char(0xD1)); r.push_back(char(0x91)); }
+            else                             { r.push_back(char(c));    r.push_back(char(d)); }
+        } else {
+            r.push_back(char(c));
+        }
+    }
+    return r;
+}
+
+// Код символа UTF-8 в 10 бит: ASCII и кириллица без потерь, прочее — по модулю
+uint32_t gramSymbol(std::string_view s, size_t& i) {
+    unsigned char c = s[i++];
+    uint32_t cp = c;
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+    if (extra) cp = c & (0x3F >> extra);
+    for (; extra > 0 && i < s.size(); --extra)
+        cp = (cp << 6) | (s[i++] & 0x3F);
+    if (cp < 0x80) return cp;
+    if (cp >= 0x400 && cp < 0x500) return 0x80 + (cp - 0x400);
+    return 0x180 + cp % 0x280;
+}
+
+// Триграмма с рангом лучшего вхождения: 0 — начало строки,
+// 1 — начало слова, 2 — середина слова (см. matchRank)
+struct Gram {
+    uint32_t key;
+    uint32_t rank;
+};
+
+// Триграммы строки по символам, а не байтам; каждая — один раз с лучшим рангом
+std::vector<Gram> trigramsOf(std::string_view s) {
+    std::vector<uint32_t> sym;
+    std::vector<uint8_t> wordStart;
+    bool prevSep = true;
+    for (size_t i = 0; i < s.size(); ) {
+        unsigned char c = s[i];
+        sym.push_back(gramSymbol(s, i));
+        wordStart.push_back(prevSep);
+        prevSep = c < 0x80 && !std::isalnum(c);
+    }
+    std::vector<Gram> g;
+    if (sym.size() < 3) return g;
+    g.reserve(sym.size() - 2);
+    for (size_t i = 0; i + 2 < sym.size(); ++i)
+        g.push_back({sym[i] << 20 | sym[i + 1] << 10 | sym[i + 2],
+                     i == 0 ? 0u : wordStart[i] ? 1u : 2u});
+    std::sort(g.begin(), g.end(), [](const Gram& x, const Gram& y) {
+        return x.key != y.key ? x.key < y.key : x.rank < y.rank;
+    });
+    g.erase(std::unique(g.begin(), g.end(),
+                        [](const Gram& x, const Gram& y) { return x.key == y.key; }),
+            g.end());
+    return g;
+}
+
+// Дописать id (строго больше предыдущего) в сжатый список;
+// в младших двух битах varint хранится ранг триграммы в этом заголовке
+void postingsAppend(Postings& p, uint32_t id, uint32_t rank) {
+    uint32_t v = (p.count ? id - p.last : id) << 2 | rank;
+    while (v >= 0x80) {
+        p.bytes.push_back(uint8_t(v | 0x80));
+        v >>= 7;
+    }
+    p.bytes.push_back(uint8_t(v));
+    if (p.count % kSkipStep == 0)
+        p.skips.push_back({id, uint32_t(p.bytes.size()), rank});
+    p.last = id;
+    ++p.count;
+}
+
+// Последовательное чтение списка id с перескоком по skips
+struct PostingCursor {
+    const Postings* p;
+    uint32_t decoded = 0;   // сколько элементов уже прочитано
+    uint32_t pos = 0;       // смещение следующего varint
+    uint32_t cur = 0;
+    uint32_t rank = 0;
+    bool valid = false;
+
+    explicit PostingCursor(const Postings& pl) : p(&pl) { next(); }
+
+    void next() {
+        if (decoded == p->count) { valid = false; return; }
+        uint32_t v = 0;
+        for (int shift = 0; ; shift += 7) {
+            uint8_t b = p->bytes[pos++];
+            v |= uint32_t(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        cur = decoded ? cur + (v >> 2) : v >> 2;
+        rank = v & 3;
+        ++decoded;
+        valid = true;
+    }
+
+    // Встать на первый id >= target
+    void seek(uint32_t target) {
+        if (!valid || cur >= target) return;
+        auto it = std::upper_bound(p->skips.begin(), p->skips.end(), target,
+            [](uint32_t t, const PostingSkip& s) { return t < s.id; });
+        if (it != p->skips.begin()) {
+            --it;
+            uint32_t at = uint32_t(it - p->skips.begin()) * kSkipStep + 1;
+            if (at > decoded) {
+                decoded = at;
+                cur = it->id;
+                pos = it->offset;
+                rank = it->rank;
+            }
+        }
+        while (valid && cur < target) next();
+    }
+};
+
+void titleIndexAddGrams(TitleIndex& T, uint32_t id) {
+    for (const Gram& g : trigramsOf(T.folded(id)))
+        postingsAppend(T.grams[g.key], id, g.rank);
+}
+
+// Порядок sortedIds: по свёрнутому заголовку, одинаковые — в порядке списка.
+// seq берётся из узла, поэтому сравнивать можно только живые id.
+auto titleOrder(const BookList& L) {
+    return [&L](uint32_t x, uint32_t y) {
+        int c = L.titles.folded(x).compare(L.titles.folded(y));
+        return c != 0 ? c < 0 : L.byId[x]->seq < L.byId[y]->seq;
+    };
+}
+
+// Полная сборка по текущему реестру узлов
+void titleIndexBuild(BookList& L) {
+    TitleIndex& T = L.titles;
+    T = TitleIndex();
+    T.alive.assign(L.byId.size(), 0);
+    T.offset.push_back(0);
+    for (uint32_t id = 0; id < L.byId.size(); ++id) {
+        if (L.byId[id]) T.text += foldTitle(L.byId[id]->title);
+        T.offset.push_back(uint32_t(T.text.size()));
+    }
+    for (uint32_t id = 0; id < L.byId.size(); ++id) {
+        if (!L.byId[id]) continue;
+        T.alive[id] = 1;
+        T.sortedIds.push_back(id);
+        titleIndexAddGrams(T, id);
+    }
+    std::sort(T.sortedIds.begin(), T.sortedIds.end(), titleOrder(L));
+    T.liveCount = T.sortedIds.size();
+    T.built = true;
+}
+
+// Узел к этому моменту уже стоит в списке и имеет seq
+void titleIndexAdd(BookList& L, uint32_t id, std::string_view title) {
+    TitleIndex& T = L.titles;
+    if (!T.built) return;
+    // id выдаются подряд, поэтому новый заголовок всегда дописывается в конец
+    T.text += foldTitle(title);
+    T.offset.push_back(uint32_t(T.text.size()));
+    T.alive.resize(id + 1, 0);
+    T.alive[id] = 1;
+    ++T.liveCount;
+    titleIndexAddGrams(T, id);
+    T.pendingIds.push_back(id);
+    if (T.pendingIds.size() >= kPendingLimit) {
+        auto less = titleOrder(L);
+        std::vector<uint32_t> merged;
+        merged.reserve(T.sortedIds.size() + T.pendingIds.size());
+        for (uint32_t x : T.sortedIds)
+            if (T.alive[x]) merged.push_back(x);
+        size_t mid = merged.size();
+        for (uint32_t x : T.pendingIds)
+            if (T.alive[x]) merged.push_back(x);
+        std::sort(merged.begin() + mid, merged.end(), less);
+        std::inplace_merge(merged.begin(), merged.begin() + mid, merged.end(), less);
+        T.sortedIds.swap(merged);
+        T.pendingIds.clear();
+    }
+}
+
+// Список переставлен: заново упорядочить sortedIds (триграммы не зависят от порядка)
+void titleIndexReorder(BookList& L) {
+    TitleIndex& T = L.titles;
+    if (!T.built) return;
+    std::vector<uint32_t> ids;
+    ids.reserve(T.liveCount);
+    for (const std::vector<uint32_t>* v : {&T.sortedIds, &T.pendingIds})
+        for (uint32_t x : *v)
+            if (T.alive[x]) ids.push_back(x);
+    std::sort(ids.begin(), ids.end(), titleOrder(L));
+    T.sortedIds.swap(ids);
+    T.pendingIds.clear();
+}
+
+// Удалённые id остаются в списках триграмм и отсеиваются при чтении;
+// когда мёртвых становится больше живых, индекс пересобирается.
+void titleIndexRemove(TitleIndex& T, uint32_t id) {
+    if (!T.built) return;
+    T.alive[id] = 0;   // текст не трогаем: по нему упорядочен sortedIds
+    --T.liveCount;
+    ++T.deadCount;
+    if (T.deadCount > T.liveCount) T.built = false;
+}
+
+void ensureTitleIndex(BookList& L) {
+    if (!L.titles.built) titleIndexBuild(L);
+}
+
+// Примерный объём индекса в байтах
+size_t titleIndexBytes(const TitleIndex& T) {
+    size_t bytes = T.sortedIds.capacity() * sizeof(uint32_t)
+                 + T.pendingIds.capacity() * sizeof(uint32_t)
+                 + T.alive.capacity()
+                 + T.offset.capacity() * sizeof(uint32_t)
+                 + T.text.capacity();
+    for (const auto& kv : T.grams)
+        bytes += sizeof(kv) + sizeof(void*)
+               + kv.second.bytes.capacity()
+               + kv.second.skips.capacity() * sizeof(PostingSkip);
+    return bytes;
+}
+
+// Живые id с префиксом p: до limit первых по алфавиту из sortedIds
+// и все подходящие из pendingIds (порядок не гарантируется)
+std::vector<uint32_t> prefixIds(const TitleIndex& T, std::string_view p, size_t limit) {
+    auto starts = [&](uint32_t id) {
+        return T.alive[id] && T.folded(id).substr(0, p.size()) == p;
+    };
+    std::vector<uint32_t> ids;
+    auto it = std::lower_bound(T.sortedIds.begin(), T.sortedIds.end(), p,
+        [&](uint32_t id, std::string_view key) { return T.folded(id) < key; });
+    for (; it != T.sortedIds.end() && ids.size() < limit; ++it) {
+        if (!T.alive[*it]) continue;
+        if (!starts(*it)) break;
+        ids.push_back(*it);
+    }
+    for (uint32_t id : T.pendingIds)
+        if (starts(id)) ids.push_back(id);
+    return ids;
+}
+
+// Ранг совпадения: 0 — с начала, 1 — с начала слова, 2 — внутри слова
+int matchRank(std::string_view folded, size_t pos) {
+    if (pos == 0) return 0;
+    unsigned char prev = folded[pos - 1];
+    return (prev < 0x80 && !std::isalnum(prev)) ? 1 : 2;
+}
+
+// Лучший ранг среди всех вхождений q в f; -1, если вхождений нет
+int bestMatchRank(std::string_view f, std::string_view q) {
+    int best = -1;
+    for (size_t pos = f.find(q); pos != std::string_view::npos; pos = f.find(q, pos + 1)) {
+        int r = matchRank(f, pos);
+        if (best < 0 || r < best) best = r;
+        if (best <= 1) break;   // ранг 0 возможен только на первом вхождении
+    }
+    return best;
+}
+
+// До k лучших книг, в заголовке которых есть фрагмент (без учёта регистра).
+// Порядок: ранг совпадения, затем порядок добавления (id).
+std::vector<BookNode*> searchTitle(BookList& L, const std::string& fragment, size_t k) {
+    ensureTitleIndex(L);
+    const TitleIndex& T = L.titles;
+    const std::string q = foldTitle(fragment);
+    std::vector<BookNode*> result;
+    if (q.empty() || k == 0) return result;
+
+    std::vector<uint32_t> hits[3];   // найденные id по рангу
+    std::vector<Gram> grams = trigramsOf(q);
+    if (grams.empty()) {
+        // Короче триграммы: ранг 0 — это префикс, его даёт sortedIds;
+        // остальное ищем проходом по id, пока не наберётся k лучших
+        hits[0] = prefixIds(T, q, SIZE_MAX);
+        size_t better = hits[0].size();
+        for (uint32_t id = 0; id < T.alive.size() && better < k; ++id) {
+            if (!T.alive[id]) continue;
+            int r = bestMatchRank(T.folded(id), q);
+            if (r == 1) { hits[1].push_back(id); ++better; }
+            if (r == 2) hits[2].push_back(id);
+        }
+    } else {
+        // Пересечение списков; ранг первой триграммы запроса в заголовке —
+        // нижняя граница ранга совпадения, по нему раскладываем кандидатов
+        std::vector<const Postings*> lists;
+        const Postings* first = nullptr;
+        for (const Gram& g : grams) {
+            auto it = T.grams.find(g.key);
+            if (it == T.grams.end()) return result;
+            lists.push_back(&it->second);
+            if (g.rank == 0) first = &it->second;
+        }
+        std::sort(lists.begin(), lists.end(),
+                  [](const Postings* x, const Postings* y) { return x->count < y->count; });
+        std::vector<PostingCursor> cursors;
+        size_t firstAt = 0;
+        for (size_t i = 0; i < lists.size(); ++i) {
+            cursors.emplace_back(*lists[i]);
+            if (lists[i] == first) firstAt = i;
+        }
+        std::vector<uint32_t> bucket[3];
+        // идём по самому короткому списку, остальные догоняем через seek
+        for (bool more = true; more && cursors[0].valid; cursors[0].next()) {
+            uint32_t id = cursors[0].cur;
+            bool inAll = true;
+            for (size_t i = 1; i < cursors.size() && inAll; ++i) {
+                cursors[i].seek(id);
+                more = cursors[i].valid;
+                inAll = more && cursors[i].cur == id;
+            }
+            if (inAll) bucket[cursors[firstAt].rank].push_back(id);
+        }
+
+        // Проверяем корзины по порядку и останавливаемся, как только
+        // k лучших уже известны: непроверенные кандидаты корзины r
+        // имеют ранг не лучше r и id больше текущего
+        for (int r = 0; r < 3; ++r) {
+            size_t below = 0;
+            for (int b = 0; b < r; ++b) below += hits[b].size();
+            std::vector<uint32_t>& same = hits[r];
+            std::sort(same.begin(), same.end());
+            size_t earlier = same.size(), ep = 0, cur = 0;
+            for (uint32_t id : bucket[r]) {
+                while (ep < earlier && same[ep] < id) ++ep;
+                if (below + ep + cur >= k) break;
+                if (!T.alive[id]) continue;
+                int rr = bestMatchRank(T.folded(id), q);
+                if (rr < 0) continue;
+                hits[rr].push_back(id);
+                if (rr == r) ++cur;
+            }
+            if (below + hits[r].size() >= k) break;
+        }
+    }
+
+    for (int r = 0; r < 3 && result.size() < k; ++r) {
+        std::sort(hits[r].begin(), hits[r].end());
+        for (size_t i = 0; i < hits[r].size() && result.size() < k; ++i)
+            result.push_back(L.byId[hits[r][i]]);
+    }
+    return result;
+}
+
+// До k книг, чей заголовок начинается с prefix, в алфавитном порядке
+std::vector<BookNode*> findByTitlePrefix(BookList& L, const std::string& prefix, size_t k) {
+    ensureTitleIndex(L);
+    const TitleIndex& T = L.titles;
+    std::vector<uint32_t> ids = prefixIds(T, foldTitle(prefix), k);
+    std::sort(ids.begin(), ids.end(),
+              [&](uint32_t x, uint32_t y) { return T.folded(x) < T.folded(y); });
+    if (ids.size() > k) ids.resize(k);
+
+    std::vector<BookNode*> result;
+    for (uint32_t id : ids) result.push_back(L.byId[id]);
+    return result;
+}
+
+// Первая по списку книга с точно таким заголовком. В sortedIds одинаковые
+// заголовки идут в порядке списка, так что хватает первого совпадения;
+// среди ещё не слитых pendingIds выбираем наименьший seq.
+BookNode* titleFirstEqual(BookList& L, const std::string& key) {
+    ensureTitleIndex(L);
+    const TitleIndex& T = L.titles;
+    const std::string f = foldTitle(key);
+    BookNode* best = nullptr;
+    auto it = std::lower_bound(T.sortedIds.begin(), T.sortedIds.end(), f,
+        [&](uint32_t id, const std::string& k) { return T.folded(id) < k; });
+    for (; it != T.sortedIds.end(); ++it) {
+        if (!T.alive[*it]) continue;
+        if (T.folded(*it) != f) break;
+        if (L.byId[*it]->title == key) {
+            best = L.byId[*it];
+            break;
+        }
+    }
+    for (uint32_t id : T.pendingIds) {
+        if (!T.alive[id] || T.folded(id) != f) continue;
+        BookNode* n = L.byId[id];
+        if (n->title == key && (!best || n->seq < best->seq)) best = n;
+    }
+    return best;
+}
+
+// Занести узел в реестр и индекс
+void registerNode(BookList& L, BookNode* node) {
+    node->id = uint32_t(L.byId.size());
+    L.byId.push_back(node);
+    titleIndexAdd(L, node->id, node->title);
+    ++L.version;
+}
+
+void unregisterNode(BookList& L, BookNode* node) {
+    titleIndexRemove(L.titles, node->id);
+    L.byId[node->id] = nullptr;
+    ++L.version;
+}
+
+// ==== Индекс по году ====
+
+const size_t kYearBlock = 256;   // записей в блоке сводки
+
+void yearIndexBuild(BookList& L) {
+    YearIndex& Y = L.years;
+    Y = YearIndex();
+    std::vector<std::pair<int, uint32_t>> order;
+    order.reserve(L.count);
+    for (uint32_t id = 0; id < L.byId.size(); ++id)
+        if (L.byId[id]) order.push_back({L.byId[id]->year, id});
+    std::sort(order.begin(), order.end());
+
+    std::unordered_map<std::string, uint32_t> authorNo;
+    Y.years.reserve(order.size());
+    Y.pages.reserve(order.size());
+    Y.ids.reserve(order.size());
+    Y.authorOf.reserve(order.size());
+    for (const auto& e : order) {
+        const BookNode* n = L.byId[e.second];
+        auto ins = authorNo.emplace(n->author.str(), uint32_t(Y.authorNames.size()));
+        if (ins.second) Y.authorNames.push_back(ins.first->first);
+        Y.years.push_back(n->year);
+        Y.pages.push_back(n->pages);
+        Y.ids.push_back(e.second);
+        Y.authorOf.push_back(ins.first->second);
+    }
+
+    for (size_t from = 0; from < Y.ids.size(); from += kYearBlock) {
+        size_t to = std::min(Y.ids.size(), from + kYearBlock);
+        YearBlock b{Y.years[from], Y.years[to - 1], uint32_t(to - from), 0, {}};
+        std::vector<uint32_t> a(Y.authorOf.begin() + from, Y.authorOf.begin() + to);
+        std::sort(a.begin(), a.end());
+        for (size_t i = from; i < to; ++i) b.pages += Y.pages[i];
+        for (size_t i = 0; i < a.size(); ) {
+            size_t j = i;
+            while (j < a.size() && a[j] == a[i]) ++j;
+            b.authors.push_back({a[i], uint32_t(j - i)});
+            i = j;
+        }
+        Y.blocks.push_back(std::move(b));
+    }
+    Y.version = L.version;
+}
+
+const YearIndex& ensureYearIndex(BookList& L) {
+    if (L.years.version != L.version) yearIndexBuild(L);
+    return L.years;
+}
+
+// Обход индекса по годам [lo, hi]: whole(блок) для блоков целиком внутри
+// диапазона, part(позиция) для записей крайних блоков
+template <class Whole, class Part>
+void yearIndexScan(const YearIndex& Y, int lo, int hi, Whole whole, Part part) {
+    auto b = std::lower_bound(Y.blocks.begin(), Y.blocks.end(), lo,
+        [](const YearBlock& blk, int y) { return blk.maxYear < y; });
+    for (; b != Y.blocks.end() && b->minYear <= hi; ++b) {
+        if (lo <= b->minYear && b->maxYear <= hi) {
+            whole(*b);
+            continue;
+        }
+        size_t from = size_t(b - Y.blocks.begin()) * kYearBlock;
+        for (size_t i = from; i < from + b->count; ++i)
+            if (Y.years[i] >= lo && Y.years[i] <= hi) part(i);
+    }
+}
+
+// Все книги с годом в [lo, hi] по возрастанию года; visit(const BookNode&)
+template <class Visit>
+void findByYearRange(BookList& L, int lo, int hi, Visit visit) {
+    const YearIndex& Y = ensureYearIndex(L);
+    auto first = std::lower_bound(Y.years.begin(), Y.years.end(), lo);
+    for (size_t i = size_t(first - Y.years.begin()); i < Y.years.size() && Y.years[i] <= hi; ++i)
+        visit(static_cast<const BookNode&>(*L.byId[Y.ids[i]]));
+}
+
+struct YearStats {
+    size_t count = 0;
+    int64_t pages = 0;
+    double avgPages() const { return count ? double(pages) / count : 0.0; }
+};
+
+// Число книг и страниц за годы [lo, hi] — по сводкам блоков
+YearStats yearRangeStats(BookList& L, int lo, int hi) {
+    const YearIndex& Y = ensureYearIndex(L);
+    YearStats st;
+    yearIndexScan(Y, lo, hi,
+        [&](const YearBlock& b) { st.count += b.count; st.pages += b.pages; },
+        [&](size_t i) { ++st.count; st.pages += Y.pages[i]; });
+    return st;
+}
+
+// Число книг каждого автора за годы [lo, hi], по убыванию; не больше top авторов
+std::vector<std::pair<std::string, size_t>> authorCountsInRange(BookList& L, int lo, int hi,
+                                                                size_t top = SIZE_MAX) {
+    const YearIndex& Y = ensureYearIndex(L);
+    std::vector<size_t> cnt(Y.authorNames.size(), 0);
+    yearIndexScan(Y, lo, hi,
+        [&](const YearBlock& b) { for (const auto& a : b.authors) cnt[a.first] += a.second; },
+        [&](size_t i) { ++cnt[Y.authorOf[i]]; });
+    std::vector<uint32_t> order;
+    for (uint32_t a = 0; a < cnt.size(); ++a)
+        if (cnt[a]) order.push_back(a);
+    auto more = [&](uint32_t x, uint32_t y) {
+        return cnt[x] != cnt[y] ? cnt[x] > cnt[y] : x < y;
+    };
+    top = std::min(top, order.size());
+    std::partial_sort(order.begin(), order.begin() + top, order.end(), more);
+    std::vector<std::pair<std::string, size_t>> result;
+    result.reserve(top);
+    for (size_t i = 0; i < top; ++i)
+        result.push_back({Y.authorNames[order[i]], cnt[order[i]]});
+    return result;
+}
+
+// ==== Кэш запросов ====
+
+using QueryIds = std::shared_ptr<const std::vector<uint32_t>>;
+
+// Сбросить записи, если каталог изменился с момента их появления
+void queryCacheSync(QueryCache& C, uint64_t version) {
+    if (C.version == version) return;
+    if (!C.lru.empty()) ++C.invalidations;
+    C.byKey.clear();
+    C.lru.clear();
+    C.bytes = 0;
+    C.version = version;
+}
+
+QueryIds queryCacheFind(QueryCache& C, uint64_t version, std::string_view key) {
+    queryCacheSync(C, version);
+    auto it = C.byKey.find(key);
+    if (it == C.byKey.end()) {
+        ++C.misses;
+        return nullptr;
+    }
+    ++C.hits;
+    C.lru.splice(C.lru.begin(), C.lru, it->second);
+    return it->second->ids;
+}
+
+void queryCacheStore(QueryCache& C, std::string key, QueryIds ids) {
+    size_t bytes = key.size() + ids->size() * sizeof(uint32_t) + kQueryEntryOverhead;
+    if (bytes > C.limit) return;
+    C.lru.push_front({std::move(key), std::move(ids), bytes});
+    C.byKey[C.lru.front().key] = C.lru.begin();
+    C.bytes += bytes;
+    while (C.bytes > C.limit) {
+        const QueryCache::Entry& old = C.lru.back();
+        C.bytes -= old.bytes;
+        C.byKey.erase(old.key);
+        C.lru.pop_back();
+        ++C.evictions;
+    }
+}
+
+// Ответ из кэша или compute() — std::vector<uint32_t> id книг
+template <class Compute>
+QueryIds cachedQuery(BookList& L, std::string key, Compute compute) {
+    if (QueryIds ids = queryCacheFind(L.queries, L.version, key)) return ids;
+    QueryIds ids = std::make_shared<const std::vector<uint32_t>>(compute());
+    queryCacheStore(L.queries, std::move(key), ids);
+    return ids;
+}
+
+// ==== Порядок в списке ====
+
+// seq узлов растёт от головы к хвосту с пропусками по kSeqGap, так что
+// из нескольких узлов первый по списку находится без прохода. Новый узел
+// в начале или в конце получает соседний номер, вставленный в середину —
+// середину промежутка; когда промежуток кончился, список перенумеровывается.
+const uint64_t kSeqGap   = uint64_t(1) << 20;
+const uint64_t kSeqStart = uint64_t(1) << 62;
+
+void renumberList(BookList& L) {
+    uint64_t s = kSeqStart;
+    for (BookNode* cur = L.head; cur; cur = cur->next, s += kSeqGap) cur->seq = s;
+}
+
+// Номер для узла, уже вставленного после prev (nullptr — в начало)
+void assignSeq(BookList& L, const BookNode* prev, BookNode* node) {
+    const BookNode* next = node->next;
+    if (!prev && !next) {
+        node->seq = kSeqStart;
+        return;
+    }
+    bool room = !prev ? next->seq >= kSeqGap
+              : !next ? prev->seq <= UINT64_MAX - kSeqGap
+              : next->seq - prev->seq >= 2;
+    if (!room) {
+        renumberList(L);
+        return;
+    }
+    node->seq = !prev ? next->seq - kSeqGap
+              : !next ? prev->seq + kSeqGap
+              : prev->seq + (next->seq - prev->seq) / 2;
+}
+
+// ==== Базовые операции с узлами ====
+
+// Добавить в начало (в индекс — после того, как узел получил seq)
+void addFront(BookList& L, BookNode* node) {
+    node->next = L.head;
+    L.head = node;
+    if (!L.tail) L.tail = node;
+    assignSeq(L, nullptr, node);
+    registerNode(L, node);
+    ++L.count;
+}
+
+// Добавить в конец
+void addBack(BookList& L, BookNode* node) {
+    node->next = nullptr;
+    BookNode* prev = L.tail;
+    if (!L.head) L.head = node;
+    else         L.tail->next = node;
+    L.tail = node;
+    assignSeq(L, prev, node);
+    registerNode(L, node);
+    ++L.count;
+}
+
+// Добавить после элемента с данным заголовком
+bool addAfter(BookList& L, const std::string& keyTitle, BookNode* node) {
+    for (BookNode* cur = L.head; cur; cur = cur->next) {
+        if (cur->title == keyTitle) {
+            node->next = cur->next;
+            cur->next = node;
+            if (L.tail == cur) L.tail = node;
+            assignSeq(L, cur, node);
+            registerNode(L, node);
+            ++L.count;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Выцепить из списка первую книгу с таким заголовком; узел не освобождается
+BookNode* unlinkByTitle(BookList& L, const std::string& keyTitle) {
+    BookNode* cur = L.head;
+    BookNode* prev = nullptr;
+    while (cur) {
+        if (cur->title == keyTitle) {
+            if (!prev) L.head = cur->next;
+            else       prev->next = cur->next;
+            if (L.tail == cur) L.tail = prev;
+            unregisterNode(L, cur);
+            --L.count;
+            return cur;
+        }
+        prev = cur;
+        cur  = cur->next;
+    }
+    return nullptr;
+}
+
+// Удалить по заголовку (первое вхождение)
+bool removeByTitle(BookList& L, const std::string& keyTitle) {
+    BookNode* n = unlinkByTitle(L, keyTitle);
+    if (!n) return false;
+    freeBook(L, n);
+    return true;
+}
+
+// Поиск по заголовку (возвращает указатель или nullptr)
+BookNode* findByTitle(BookList& L, const std::string& key) {
+    return titleFirstEqual(L, key);
+}
+
+// Все книги автора в порядке списка
+template <class Visit>
+void forEachByAuthor(const BookList& L, const std::string& key, Visit visit) {
+    for (const BookNode* cur = L.head; cur; cur = cur->next)
+        if (cur->author == key)
+            visit(*cur);
+}
+
+// id книг автора в порядке списка (через кэш запросов)
+QueryIds booksByAuthor(BookList& L, const std::string& key) {
+    return cachedQuery(L, "a:" + key, [&] {
+        std::vector<uint32_t> ids;
+        forEachByAuthor(L, key, [&](const BookNode& b) { ids.push_back(b.id); });
+        return ids;
+    });
+}
+
+// id книг года в порядке индекса по году (через кэш запросов)
+QueryIds booksByYear(BookList& L, int key) {
+    return cachedQuery(L, "y:" + std::to_string(key), [&] {
+        std::vector<uint32_t> ids;
+        findByYearRange(L, key, key, [&](const BookNode& b) { ids.push_back(b.id); });
+        return ids;
+    });
+}
+
+// Вывод по автору
+void findByAuthor(BookList& L, const std::string& key) {
+    QueryIds ids = booksByAuthor(L, key);
+    for (uint32_t id : *ids) {
+        const BookNode& b = *L.byId[id];
+        std::cout << "  «" << b.title << "», "
+                  << b.year << ", " << b.publisher
+                  << ", " << b.pages << " стр.\n";
+    }
+    if (ids->empty()) std::cout << "Не найдено книг автора «" << key << "»\n";
+}
+
+// Вывод по году
+void findByYear(BookList& L, int key) {
+    QueryIds ids = booksByYear(L, key);
+    for (uint32_t id : *ids) {
+        const BookNode& b = *L.byId[id];
+        std::cout << "  «" << b.title << "», "
+                  << b.author << ", " << b.publisher
+                  << ", " << b.pages << " стр.\n";
+    }
+    if (ids->empty()) std::cout << "Не найдено книг за " << key << " год\n";
+}
+
+// Вывести весь список
+void printList(const BookList& L) {
+    std::cout << "Всего книг: " << L.count << "\n";
+    size_t idx = 1;
+    for (BookNode* cur = L.head; cur; cur = cur->next, ++idx) {
+        std::cout << idx << ") «" << cur->title << "», "
+                  << cur->author << ", " << cur->year << ", "
+                  << cur->publisher << ", " << cur->pages << " стр.\n";
+    }
+}
+
+// ==== Сохранение/загрузка в бинарный файл ====
+
+// Сравнение узлов (все поля)
+bool equals(const BookNode* A, const BookNode* B) {
+    return A->title     == B->title
+        && A->author    == B->author
+        && A->year      == B->year
+        && A->publisher == B->publisher
+        && A->pages     == B->pages;
+}
+
+// Формат файла блочный: [kBlockMagic][блок 0]…[блок k−1][оглавление][BlockFooter].
+// Блок — до kBlockBooks записей подряд в прежней раскладке (длина + байты
+// строк, год и страницы как int). Оглавление хранит смещение, размер и число
+// книг каждого блока, поэтому блоки пишутся и читаются независимо в
+// нескольких потоках и склеиваются по порядку. Старый формат (число книг,
+// затем записи) по-прежнему читается.
+//
+// Сжатый вариант (kPackedMagic) после магии хранит словарь авторов и
+// издательств: [u64 размер][varint число строк][varint длина + байты]…
+// Блок: [varint исходный размер, 0 — без LZ][данные, возможно сжатые LZ];
+// данные — varint базовый год (zigzag), затем записи: varint длина и байты
+// заголовка, varint номер автора, varint год − база, varint номер
+// издательства, varint страниц (zigzag).
+const char   kBlockMagic[8]  = {'B', 'O', 'O', 'K', 'B', 'L', 'K', '1'};
+const char   kPackedMagic[8] = {'B', 'O', 'O', 'K', 'D', 'I', 'C', '1'};
+const size_t kBlockBooks = 16384;     // книг в одном блоке файла
+const size_t kMinRecord = 20;         // байт в записи с пустыми строками
+const uint64_t kMaxPackRatio = 256;   // больше книг на байт сжатого блока не бывает
+
+enum class BookFormat { Plain, Packed, PackedLz };
+
+struct BlockEntry {
+    uint64_t offset;
+    uint64_t bytes;
+    uint64_t books;
+};
+
+struct BlockFooter {
+    uint64_t blocks;
+    uint64_t books;
+    uint64_t tableOffset;
+    char magic[8];
+};
+
+// Сколько потоков дать на работу из blocks блоков (wanted = 0 — по числу ядер)
+unsigned ioThreads(size_t blocks, unsigned wanted) {
+    unsigned t = wanted ? wanted : std::max(1u, std::thread::hardware_concurrency());
+    return unsigned(std::max<size_t>(1, std::min<size_t>(t, blocks)));
+}
+
+// Запустить fn(номер) на threads потоках, нулевой — текущий
+template <class Fn>
+void runWorkers(unsigned threads, Fn fn) {
+    std::vector<std::thread> pool;
+    for (unsigned w = 1; w < threads; ++w) pool.emplace_back(fn, w);
+    fn(0u);
+    for (std::thread& th : pool) th.join();
+}
+
+// Закодировать n записей nodes[0..n) в out
+void encodeBlock(const BookNode* const* nodes, size_t n, std::string& out) {
+    out.clear();
+    auto put = [&](const void* p, size_t len) { out.append(static_cast<const char*>(p), len); };
+    auto wrs = [&](std::string_view s) {
+        uint32_t len = uint32_t(s.size());
+        put(&len, sizeof(len));
+        put(s.data(), len);
+    };
+    for (size_t i = 0; i < n; ++i) {
+        const BookNode* cur = nodes[i];
+        wrs(cur->title);
+        wrs(cur->author);
+        put(&cur->year, sizeof(cur->year));
+        wrs(cur->publisher);
+        put(&cur->pages, sizeof(cur->pages));
+    }
+}
+
+// Разобрать блок из n записей в узлы пула P с id от firstId, занести их
+// в slots и связать цепочкой first…last. false, если блок испорчен.
+bool decodeBlock(NodePool& P, const char* p, size_t bytes, size_t n, uint32_t firstId,
+                 BookNode** slots, BookNode*& first, BookNode*& last) {
+    const char* end = p + bytes;
+    auto rdi = [&](int& x) {
+        if (size_t(end - p) < sizeof(x)) return false;
+        std::memcpy(&x, p, sizeof(x));
+        p += sizeof(x);
+        return true;
+    };
+    auto rds = [&](std::string_view& s) {
+        uint32_t len;
+        if (size_t(end - p) < sizeof(len)) return false;
+        std::memcpy(&len, p, sizeof(len));
+        p += sizeof(len);
+        if (size_t(end - p) < len) return false;
+        s = std::string_view(p, len);
+        p += len;
+        return true;
+    };
+    first = last = nullptr;
+    for (size_t i = 0; i < n; ++i) {
+        std::string_view t, a, pub;
+        int y, pg;
+        if (!rds(t) || !rds(a) || !rdi(y) || !rds(pub) || !rdi(pg)) return false;
+        BookNode* node = makeBook(P, t, a, y, pub, pg);
+        node->id = firstId + uint32_t(i);
+        slots[i] = node;
+        if (last) last->next = node;
+        else      first = node;
+        last = node;
+    }
+    return p == end;
+}
+
+void putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out += char(v | 0x80);
+        v >>= 7;
+    }
+    out += char(v);
+}
+
+bool getVarint(const char*& p, const char* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p == end) return false;
+        unsigned char b = *p++;
+        v |= uint64_t(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+inline uint64_t zigzag(int64_t x) { return uint64_t(x) << 1 ^ uint64_t(x >> 63); }
+inline int64_t unzigzag(uint64_t v) { return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+// Сжатие LZ77 в духе LZ4: последовательности «литералы + совпадение».
+// Токен: старшие 4 бита — число литералов, младшие — длина совпадения − 4
+// (15 — продолжается байтами до первого не-255), затем литералы и 2 байта
+// смещения. Последняя последовательность — только литералы. Дописывает в out.
+void lzCompress(const char* src, size_t n, std::string& out) {
+    const int kHashBits = 14;
+    std::vector<uint32_t> last(size_t(1) << kHashBits, UINT32_MAX);   // хеш 4 байт → позиция
+    auto putLen = [&](size_t len) {
+        for (; len >= 255; len -= 255) out += char(255);
+        out += char(len);
+    };
+    auto literals = [&](size_t from, size_t to, size_t matchNibble) {
+        size_t lit = to - from;
+        out += char(std::min<size_t>(lit, 15) << 4 | matchNibble);
+        if (lit >= 15) putLen(lit - 15);
+        out.append(src + from, lit);
+    };
+    size_t anchor = 0;
+    for (size_t i = 0; i + 4 <= n; ) {
+        uint32_t v, w;
+        std::memcpy(&v, src + i, 4);
+        uint32_t& slot = last[(v * 2654435761u) >> (32 - kHashBits)];
+        uint32_t cand = slot;
+        slot = uint32_t(i);
+        if (cand == UINT32_MAX || i - cand > 0xFFFF
+            || (std::memcpy(&w, src + cand, 4), w != v)) {
+            ++i;
+            continue;
+        }
+        size_t len = 4;
+        while (i + len < n && src[cand + len] == src[i + len]) ++len;
+        literals(anchor, i, std::min<size_t>(len - 4, 15));
+        out += char((i - cand) & 0xFF);
+        out += char((i - cand) >> 8);
+        if (len - 4 >= 15) putLen(len - 4 - 15);
+        i += len;
+        anchor = i;
+    }
+    literals(anchor, n, 0);
+}
+
+const size_t kLzSlack = 16;   // запас за концом буфера распаковки
+
+// Копирование кусками по step байт: пишет и читает до step − 1 байт
+// лишних, зато без побайтового цикла
+template <size_t step>
+inline void wildCopy(char* dst, const char* src, size_t len) {
+    for (size_t k = 0; k < len; k += step) std::memcpy(dst + k, src + k, step);
+}
+
+// Распаковать ровно n байт в dst, за которым есть ещё kLzSlack байт;
+// false, если данные испорчены
+bool lzDecompress(const char* p, size_t bytes, char* dst, size_t n) {
+    const char* end = p + bytes;
+    size_t o = 0;
+    auto getLen = [&](size_t& len) {
+        unsigned char b;
+        do {
+            if (p == end) return false;
+            b = *p++;
+            len += b;
+        } while (b == 255);
+        return true;
+    };
+    while (p < end) {
+        unsigned char tok = *p++;
+        size_t lit = tok >> 4;
+        if (lit == 15 && !getLen(lit)) return false;
+        if (size_t(end - p) < lit || n - o < lit) return false;
+        if (size_t(end - p) >= lit + kLzSlack) wildCopy<16>(dst + o, p, lit);
+        else                                   std::memcpy(dst + o, p, lit);
+        p += lit;
+        o += lit;
+        if (p == end) break;
+        if (end - p < 2) return false;
+        size_t off = size_t((unsigned char)p[0]) | size_t((unsigned char)p[1]) << 8;
+        p += 2;
+        size_t len = tok & 15;
+        if (len == 15 && !getLen(len)) return false;
+        len += 4;
+        if (off == 0 || off > o || n - o < len) return false;
+        if (off >= 16)     wildCopy<16>(dst + o, dst + o - off, len);
+        else if (off >= 8) wildCopy<8>(dst + o, dst + o - off, len);
+        else for (size_t k = 0; k < len; ++k) dst[o + k] = dst[o - off + k];   // перекрытие
+        o += len;
+    }
+    return o == n;
+}
+
+// Словарь строк: номер в порядке появления. Открытая адресация, строки
+// подряд в одном буфере — при поиске не приходится читать чужие узлы.
+struct StringDict {
+    std::vector<uint64_t> slots = std::vector<uint64_t>(1024);  // хеш >> 32 << 32 | номер + 1
+    std::vector<uint32_t> offset = {0};   // номер → начало в text; offset[id + 1] — конец
+    std::string text;
+
+    static uint64_t hash(std::string_view s) {
+        uint64_t h = 1469598103934665603ull;   // FNV-1a
+        for (unsigned char c : s) h = (h ^ c) * 1099511628211ull;
+        return h;
+    }
+
+    size_t size() const { return offset.size() - 1; }
+
+    std::string_view at(uint32_t id) const {
+        return std::string_view(text).substr(offset[id], offset[id + 1] - offset[id]);
+    }
+
+    uint32_t intern(std::string_view s) {
+        uint64_t h = hash(s);
+        size_t mask = slots.size() - 1;
+        for (size_t i = h & mask; ; i = (i + 1) & mask) {
+            uint64_t e = slots[i];
+            if (!e) break;
+            uint32_t id = uint32_t(e) - 1;
+            if (e >> 32 == h >> 32 && at(id) == s) return id;
+        }
+        uint32_t id = uint32_t(size());
+        text.append(s.data(), s.size());
+        offset.push_back(uint32_t(text.size()));
+        if (2 * size() > slots.size()) {
+            slots.assign(2 * slots.size(), 0);
+            for (uint32_t k = 0; k <= id; ++k) place(hash(at(k)), k);
+        } else {
+            place(h, id);
+        }
+        return id;
+    }
+
+private:
+    void place(uint64_t h, uint32_t id) {
+        size_t mask = slots.size() - 1;
+        size_t i = h & mask;
+        while (slots[i]) i = (i + 1) & mask;
+        slots[i] = h >> 32 << 32 | (id + 1);
+    }
+};
+
+// Словарь авторов и издательств в файловом виде; refs[2i], refs[2i + 1] —
+// номера автора и издательства книги nodes[i]
+std::string buildDict(const std::vector<const BookNode*>& nodes, std::vector<uint32_t>& refs) {
+    StringDict dict;
+    refs.resize(2 * nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        refs[2 * i]     = dict.intern(nodes[i]->author);
+        refs[2 * i + 1] = dict.intern(nodes[i]->publisher);
+    }
+    std::string out;
+    putVarint(out, dict.size());
+    for (uint32_t id = 0; id < dict.size(); ++id) {
+        putVarint(out, dict.at(id).size());
+        out += dict.at(id);
+    }
+    return out;
+}
+
+// Закодировать n записей сжатого формата в out (raw — рабочий буфер)
+void encodePackedBlock(const BookNode* const* nodes, size_t n, const uint32_t* refs, bool lz,
+                       std::string& out, std::string& raw) {
+    int base = INT32_MAX;
+    for (size_t i = 0; i < n; ++i) base = std::min(base, nodes[i]->year);
+    raw.clear();
+    putVarint(raw, zigzag(base));
+    for (size_t i = 0; i < n; ++i) {
+        const BookNode* cur = nodes[i];
+        std::string_view t = cur->title;
+        putVarint(raw, t.size());
+        raw.append(t.data(), t.size());
+        putVarint(raw, refs[2 * i]);
+        putVarint(raw, uint64_t(int64_t(cur->year) - base));
+        putVarint(raw, refs[2 * i + 1]);
+        putVarint(raw, zigzag(cur->pages));
+    }
+    out.clear();
+    if (lz) {
+        putVarint(out, raw.size());
+        lzCompress(raw.data(), raw.size(), out);
+        if (out.size() < raw.size()) return;
+        out.clear();   // не сжалось — храним как есть
+    }
+    putVarint(out, 0);
+    out += raw;
+}
+
+// Разобрать блок сжатого формата (см. decodeBlock); авторы и издательства —
+// копии строк словаря dict, их длинные тексты общие для всех узлов
+bool decodePackedBlock(NodePool& P, const char* p, size_t bytes, size_t n, uint32_t firstId,
+                       BookNode** slots, BookNode*& first, BookNode*& last,
+                       const std::vector<BookStr>& dict, std::string& raw) {
+    const char* end = p + bytes;
+    uint64_t rawSize, v;
+    if (!getVarint(p, end, rawSize)) return false;
+    if (rawSize) {
+        if (rawSize > bytes * kMaxPackRatio) return false;
+        raw.resize(rawSize + kLzSlack);
+        if (!lzDecompress(p, size_t(end - p), &raw[0], rawSize)) return false;
+        p = raw.data();
+        end = p + rawSize;
+    }
+    if (!getVarint(p, end, v)) return false;
+    int64_t base = unzigzag(v);
+    first = last = nullptr;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t len, a, dy, pub, pg;
+        if (!getVarint(p, end, len) || size_t(end - p) < len) return false;
+        std::string_view t(p, len);
+        p += len;
+        if (!getVarint(p, end, a) || a >= dict.size() || !getVarint(p, end, dy)
+            || !getVarint(p, end, pub) || pub >= dict.size() || !getVarint(p, end, pg))
+            return false;
+        BookNode* node = allocNode(P);
+        setField(P, node->title, t);
+        node->author = dict[a];
+        node->year = int(base + int64_t(dy));
+        node->publisher = dict[pub];
+        node->pages = int(unzigzag(pg));
+        node->next = nullptr;
+        node->id = firstId + uint32_t(i);
+        slots[i] = node;
+        if (last) last->next = node;
+        else      first = node;
+        last = node;
+    }
+    return p == end;
+}
+
+// Узлы списка по порядку
+std::vector<const BookNode*> listNodes(const BookList& L) {
+    std::vector<const BookNode*> nodes;
+    nodes.reserve(L.count);
+    for (const BookNode* cur = L.head; cur; cur = cur->next) nodes.push_back(cur);
+    return nodes;
+}
+
+// Записать узлы в блочном формате fmt; threads = 0 — по числу ядер.
+// progress, если задан, растёт на число книг каждого записанного блока.
+bool writeBookFile(const std::vector<const BookNode*>& nodes, const std::string& filename,
+                   unsigned threads, std::atomic<size_t>* progress = nullptr,
+                   BookFormat fmt = BookFormat::Plain) {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) return false;
+    size_t blocks = (nodes.size() + kBlockBooks - 1) / kBlockBooks;
+    auto booksIn = [&](size_t b) { return std::min(kBlockBooks, nodes.size() - b * kBlockBooks); };
+
+    bool packed = fmt != BookFormat::Plain;
+    const char* magic = packed ? kPackedMagic : kBlockMagic;
+    std::vector<BlockEntry> table(blocks);
+    out.write(magic, sizeof(kBlockMagic));
+    uint64_t offset = sizeof(kBlockMagic);
+    std::vector<uint32_t> refs;
+    if (packed) {
+        std::string dict = buildDict(nodes, refs);
+        uint64_t len = dict.size();
+        out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+        out.write(dict.data(), std::streamsize(len));
+        offset += sizeof(len) + len;
+    }
+    // блоки кодируются волнами по два на поток и пишутся по порядку,
+    // так что в памяти не больше 2·threads готовых блоков
+    threads = ioThreads(blocks, threads);
+    std::vector<std::string> buf(2 * threads), raw(threads);
+    for (size_t base = 0; base < blocks; base += buf.size()) {
+        size_t wave = std::min(buf.size(), blocks - base);
+        std::atomic<size_t> next{0};
+        runWorkers(unsigned(std::min<size_t>(threads, wave)), [&](unsigned w) {
+            for (size_t k; (k = next++) < wave; ) {
+                size_t from = (base + k) * kBlockBooks;
+                if (packed)
+                    encodePackedBlock(&nodes[from], booksIn(base + k), &refs[2 * from],
+                                      fmt == BookFormat::PackedLz, buf[k], raw[w]);
+                else
+                    encodeBlock(&nodes[from], booksIn(base + k), buf[k]);
+            }
+        });
+        for (size_t k = 0; k < wave; ++k) {
+            table[base + k] = {offset, buf[k].size(), booksIn(base + k)};
+            out.write(buf[k].data(), buf[k].size());
+            offset += buf[k].size();
+            if (progress) *progress += booksIn(base + k);
+        }
+    }
+    BlockFooter f{table.size(), nodes.size(), offset, {}};
+    std::memcpy(f.magic, magic, sizeof(f.magic));
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(BlockEntry));
+    out.write(reinterpret_cast<const char*>(&f), sizeof(f));
+    return bool(out.flush());
+}
+
+// Дописать на диск содержимое файла (dir = true — каталог: запись о rename).
+// В Windows каталоги так не сбрасываются, там хватает сброса файла.
+bool syncPath(const std::string& path, bool dir = false) {
+#ifdef _WIN32
+    if (dir) return true;
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+    if (fd < 0) return false;
+    bool ok = FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(fd))) != 0;
+    _close(fd);
+    return ok;
+#else
+    int fd = open(path.c_str(), dir ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+#endif
+}
+
+// Каталог, в котором лежит файл
+std::string parentDir(const std::string& filename) {
+    size_t slash = filename.find_last_of("/\\");
+    if (slash == std::string::npos) return ".";
+    return slash == 0 ? "/" : filename.substr(0, slash);
+}
+
+// Записать во временный файл и подменить им filename: файл на диске
+// всегда целиком старый или целиком новый. Временный файл сбрасывается
+// на диск до rename, иначе после сбоя питания под новым именем может
+// оказаться пустой или недописанный файл; каталог — после, чтобы
+// сохранилась сама подмена.
+bool replaceBookFile(const std::vector<const BookNode*>& nodes, const std::string& filename,
+                     unsigned threads, std::atomic<size_t>* progress = nullptr,
+                     BookFormat fmt = BookFormat::Plain) {
+    std::string tmp = filename + ".tmp";
+    if (!writeBookFile(nodes, tmp, threads, progress, fmt) || !syncPath(tmp)) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+#ifdef _WIN32
+    std::remove(filename.c_str());   // rename в Windows не заменяет существующий файл
+#endif
+    if (std::rename(tmp.c_str(), filename.c_str()) != 0) return false;
+    syncPath(parentDir(filename), true);   // не вышло — файл уже целый, только подмена может не дожить
+    return true;
+}
+
+// Сохранить весь список в файл (перезапись)
+void saveToFile(const BookList& L, const std::string& filename, unsigned threads = 0,
+                BookFormat fmt = BookFormat::Plain) {
+    if (!replaceBookFile(listNodes(L), filename, threads, nullptr, fmt)) {
+        std::cerr << "Не удалось записать файл «" << filename << "»\n";
+        return;
+    }
+    std::cout << "Сохранено в «" << filename << "» (" << L.count << " книг)\n";
+}
+
+// Удалить все узлы вместе с реестром и индексами: пул освобождается блоками
+void clearList(BookList& L) {
+    if (L.saving) {
+        // отложенные узлы принадлежат этому же пулу и уйдут вместе с ним
+        L.saving->retired.push_back(std::move(L.pool));
+        L.saving->deferred.clear();
+    }
+    L.pool = NodePool();
+    L.head = L.tail = nullptr;
+    L.count = 0;
+    L.byId.clear();
+    L.titles = TitleIndex();
+    L.years = YearIndex();
+    ++L.version;
+    queryCacheSync(L.queries, L.version);   // не держать память до следующего запроса
+}
+
+// Словарь сжатого формата в пул списка
+bool readDict(BookList& L, std::ifstream& in, uint64_t bytes, std::vector<BookStr>& dict) {
+    std::string buf(bytes, '\0');
+    in.read(&buf[0], std::streamsize(bytes));
+    if (!in) return false;
+    const char* p = buf.data();
+    const char* end = p + bytes;
+    uint64_t count, len;
+    if (!getVarint(p, end, count) || count > bytes) return false;
+    dict.resize(count);
+    for (BookStr& s : dict) {
+        if (!getVarint(p, end, len) || size_t(end - p) < len) return false;
+        setField(L.pool, s, std::string_view(p, len));
+        p += len;
+    }
+    return p == end;
+}
+
+// Блочный файл в пустой список. Каждый поток читает свои блоки отдельным
+// потоком файла в собственный пул; пулы и цепочки блоков потом склеиваются.
+bool readBlockFile(BookList& L, std::ifstream& in, const std::string& filename,
+                   unsigned threads, bool packed) {
+    const char* magic = packed ? kPackedMagic : kBlockMagic;
+    BlockFooter f;
+    in.seekg(0, std::ios::end);
+    uint64_t size = uint64_t(in.tellg());
+    if (size < sizeof(kBlockMagic) + sizeof(f)) return false;
+    in.seekg(size - sizeof(f));
+    in.read(reinterpret_cast<char*>(&f), sizeof(f));
+    if (!in || std::memcmp(f.magic, magic, sizeof(f.magic)) != 0
+        || f.tableOffset < sizeof(kBlockMagic) || f.tableOffset > size - sizeof(f)
+        || size - sizeof(f) - f.tableOffset != f.blocks * sizeof(BlockEntry))
+        return false;
+
+    uint64_t dataStart = sizeof(kBlockMagic);
+    std::vector<BookStr> dict;
+    if (packed) {
+        uint64_t bytes;
+        in.seekg(dataStart);
+        in.read(reinterpret_cast<char*>(&bytes), sizeof(bytes));
+        dataStart += sizeof(bytes);
+        if (!in || bytes > f.tableOffset - dataStart || !readDict(L, in, bytes, dict))
+            return false;
+        dataStart += bytes;
+    }
+
+    std::vector<BlockEntry> table(f.blocks);
+    in.seekg(f.tableOffset);
+    in.read(reinterpret_cast<char*>(table.data()), table.size() * sizeof(BlockEntry));
+    if (!in) return false;
+    std::vector<uint64_t> firstId(table.size());
+    uint64_t total = 0;
+    for (size_t b = 0; b < table.size(); ++b) {
+        const BlockEntry& e = table[b];
+        if (e.offset < dataStart || e.offset > f.tableOffset
+            || e.bytes > f.tableOffset - e.offset
+            || e.books > (packed ? e.bytes * kMaxPackRatio : e.bytes / kMinRecord))
+            return false;
+        firstId[b] = total;
+        total += e.books;
+    }
+    if (total != f.books || total >= UINT32_MAX) return false;
+
+    L.byId.assign(total, nullptr);
+    threads = ioThreads(table.size(), threads);
+    std::vector<NodePool> pools(threads);
+    std::vector<BookNode*> first(table.size()), last(table.size());
+    std::atomic<size_t> next{0};
+    std::atomic<bool> bad{false};
+    runWorkers(threads, [&](unsigned w) {
+        std::ifstream part(filename, std::ios::binary);
+        std::string buf, raw;
+        for (size_t b; !bad && (b = next++) < table.size(); ) {
+            buf.resize(table[b].bytes);
+            part.seekg(table[b].offset);
+            part.read(&buf[0], buf.size());
+            BookNode** slots = L.byId.data() + firstId[b];
+            bool ok = part && (packed
+                ? decodePackedBlock(pools[w], buf.data(), buf.size(), table[b].books,
+                                    uint32_t(firstId[b]), slots, first[b], last[b], dict, raw)
+                : decodeBlock(pools[w], buf.data(), buf.size(), table[b].books,
+                              uint32_t(firstId[b]), slots, first[b], last[b]));
+            if (!ok) bad = true;
+        }
+    });
+    if (bad) return false;
+
+    for (NodePool& P : pools) splicePool(L.pool, std::move(P));
+    for (size_t b = 0; b < table.size(); ++b) {
+        if (!first[b]) continue;
+        if (L.tail) L.tail->next = first[b];
+        else        L.head = first[b];
+        L.tail = last[b];
+    }
+    L.count = total;
+    renumberList(L);
+    ++L.version;
+    return true;
+}
+
+// Старый формат: число книг, затем записи подряд
+bool readLegacyFile(BookList& L, std::ifstream& in) {
+    size_t n;
+    in.read(reinterpret_cast<char*>(&n), sizeof(n));
+    for (size_t i = 0; in && i < n; ++i) {
+        auto rds = [&](void)->std::string {
+            uint32_t len;
+            in.read(reinterpret_cast<char*>(&len), sizeof(len));
+            std::string s(len, '\0');
+            in.read(&s[0], len);
+            return s;
+        };
+        std::string t = rds();
+        std::string a = rds();
+        int y; in.read(reinterpret_cast<char*>(&y), sizeof(y));
+        std::string p = rds();
+        int pg; in.read(reinterpret_cast<char*>(&pg), sizeof(pg));
+        if (in) addBack(L, newBook(L, t,a,y,p,pg));
+    }
+    return bool(in);
+}
+
+// Прочитать файл любого формата в пустой список; false — файл испорчен
+bool readBookFile(BookList& L, std::ifstream& in, const std::string& filename,
+                  unsigned threads) {
+    char magic[sizeof(kBlockMagic)];
+    in.read(magic, sizeof(magic));
+    if (in && std::memcmp(magic, kBlockMagic, sizeof(magic)) == 0)
+        return readBlockFile(L, in, filename, threads, false);
+    if (in && std::memcmp(magic, kPackedMagic, sizeof(magic)) == 0)
+        return readBlockFile(L, in, filename, threads, true);
+    in.clear();
+    in.seekg(0);
+    return readLegacyFile(L, in);
+}
+
+// Загрузить из файла (полная перезагрузка списка)
+void loadFromFile(BookList& L, const std::string& filename, unsigned threads = 0) {
+    // очистка текущего
+    clearList(L);
+
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        std::cerr << "Не удалось открыть файл для чтения\n";
+        return;
+    }
+    if (!readBookFile(L, in, filename, threads)) {
+        clearList(L);
+        std::cerr << "Файл «" << filename << "» повреждён\n";
+        return;
+    }
+    std::cout << "Загружено из «" << filename << "» (" << L.count << " книг)\n";
+}
+
+// Слияние: добавляем в список только тех книг из файла, которых ещё нет
+void mergeFromFile(BookList& L, const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        std::cerr << "Не удалось открыть файл для чтения\n";
+        return;
+    }
+    BookList F;
+    if (!readBookFile(F, in, filename, 0)) {
+        std::cerr << "Файл «" << filename << "» повреждён\n";
+        return;
+    }
+    size_t added = 0;
+    for (BookNode* src = F.head; src; src = src->next) {
+        bool exists = false;
+        for (BookNode* cur = L.head; cur; cur = cur->next) {
+            if (equals(cur, src)) {
+                exists = true;
+                break;
+            }
+        }
+        if (!exists) {
+            addBack(L, newBook(L, src->title, src->author, src->year,
+                               src->publisher, src->pages));
+            ++added;
+        }
+    }
+    std::cout << "Добавлено новых книг: " << added << "\n";
+}
+
+// ==== Фоновое сохранение ====
+
+// Начать сохранение в фоне; false, если предыдущее ещё идёт.
+// Снимок — указатели на узлы в порядке списка: содержимое узла не меняется,
+// пока он в списке (сортировка перевешивает узлы), а удалённые узлы и
+// сброшенные пулы удерживаются до конца записи (freeBook, clearList).
+bool startAsyncSave(BookList& L, const std::string& filename,
+                    BookFormat fmt = BookFormat::Plain) {
+    if (L.saving) return false;
+    L.saving = std::make_unique<AsyncSave>();
+    AsyncSave* s = L.saving.get();
+    s->filename = filename;
+    s->nodes = listNodes(L);
+    s->worker = std::thread([s, fmt] {
+        s->ok = replaceBookFile(s->nodes, s->filename, 0, &s->written, fmt);
+        s->done = true;
+    });
+    return true;
+}
+
+// Доля записанного фоновым сохранением (0, если оно не идёт)
+double asyncSaveProgress(const BookList& L) {
+    if (!L.saving || L.saving->nodes.empty()) return 0.0;
+    return double(L.saving->written) / L.saving->nodes.size();
+}
+
+// Завершить фоновое сохранение, если оно закончилось (или дождаться его
+// при wait): сообщить итог и вернуть отложенные узлы в пул
+bool finishAsyncSave(BookList& L, bool wait) {
+    AsyncSave* s = L.saving.get();
+    if (!s || (!wait && !s->done)) return false;
+    s->worker.join();
+    if (s->ok)
+        std::cout << "Сохранено в «" << s->filename << "» (" << s->nodes.size() << " книг)\n";
+    else
+        std::cerr << "Не удалось записать файл «" << s->filename << "»\n";
+    std::vector<BookNode*> deferred = std::move(s->deferred);
+    L.saving.reset();
+    for (BookNode* n : deferred) freeBook(L, n);
+    return true;
+}
+
+// ==== Импорт и экспорт CSV/TSV ====
+//
+// Поля строки: заголовок, автор, год, издательство, страниц. Поле в кавычках
+// может содержать разделитель, перевод строки и удвоенные кавычки (RFC 4180).
+// Разметка ищется по 64 байта за шаг: маски кавычек и разделителей, префиксный
+// XOR маски кавычек отмечает байты внутри кавычек, остаются только настоящие
+// границы полей и строк.
+
+const size_t kCsvChunk = 8 << 20;    // байт читаем и пишем за раз
+
+struct CsvStats {
+    size_t rows = 0;        // добавлено книг
+    size_t bad = 0;         // пропущено испорченных строк
+    size_t firstBad = 0;    // номер первой из них (с 1)
+    uint64_t bytes = 0;
+};
+
+// Разделитель по имени файла: .tsv — табуляция, иначе запятая
+char csvDelimiter(const std::string& filename) {
+    return filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".tsv") == 0
+         ? '\t' : ',';
+}
+
+// Биты кавычек и разделителей (delim или '\n') в 64 байтах p
+inline void csvMasks(const char* p, char delim, uint64_t& quotes, uint64_t& seps) {
+#if defined(__AVX2__)
+    const __m256i q = _mm256_set1_epi8('"'), d = _mm256_set1_epi8(delim), nl = _mm256_set1_epi8('\n');
+    auto bits = [](__m256i m) { return uint64_t(uint32_t(_mm256_movemask_epi8(m))); };
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+    quotes = bits(_mm256_cmpeq_epi8(a, q)) | bits(_mm256_cmpeq_epi8(b, q)) << 32;
+    seps = bits(_mm256_or_si256(_mm256_cmpeq_epi8(a, d), _mm256_cmpeq_epi8(a, nl)))
+         | bits(_mm256_or_si256(_mm256_cmpeq_epi8(b, d), _mm256_cmpeq_epi8(b, nl))) << 32;
+#elif defined(__SSE2__)
+    const __m128i q = _mm_set1_epi8('"'), d = _mm_set1_epi8(delim), nl = _mm_set1_epi8('\n');
+    auto bits = [](__m128i m) { return uint64_t(uint16_t(_mm_movemask_epi8(m))); };
+    quotes = seps = 0;
+    for (int i = 0; i < 4; ++i) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+        quotes |= bits(_mm_cmpeq_epi8(v, q)) << (16 * i);
+        seps   |= bits(_mm_or_si128(_mm_cmpeq_epi8(v, d), _mm_cmpeq_epi8(v, nl))) << (16 * i);
+    }
+#else
+    quotes = seps = 0;
+    for (int i = 0; i < 64; ++i) {
+        quotes |= uint64_t(p[i] == '"') << i;
+        seps   |= uint64_t(p[i] == delim || p[i] == '\n') << i;
+    }
+#endif
+}
+
+// Бит i результата — XOR битов 0..i
+inline uint64_t prefixXor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+inline int lowestBit(uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return int(i);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// Целое из поля: необязательный знак и до 9 цифр, пробелы по краям
+bool parseIntField(std::string_view s, int& out) {
+    size_t i = 0, n = s.size();
+    while (i < n && s[i] == ' ') ++i;
+    while (n > i && s[n - 1] == ' ') --n;
+    bool neg = i < n && s[i] == '-';
+    if (i < n && (s[i] == '-' || s[i] == '+')) ++i;
+    if (i == n || n - i > 9) return false;
+    int v = 0;
+    for (; i < n; ++i) {
+        unsigned d = unsigned(s[i] - '0');
+        if (d > 9) return false;
+        v = v * 10 + int(d);
+    }
+    out = neg ? -v : v;
+    return true;
+}
+
+// Значение поля: без обрамляющих кавычек, удвоенные кавычки — в scratch
+std::string_view csvValue(std::string_view f, std::string& scratch) {
+    if (f.size() < 2 || f.front() != '"' || f.back() != '"') return f;
+    f = f.substr(1, f.size() - 2);
+    if (f.find('"') == std::string_view::npos) return f;
+    scratch.clear();
+    for (size_t i = 0; i < f.size(); ++i) {
+        scratch += f[i];
+        if (f[i] == '"' && i + 1 < f.size() && f[i + 1] == '"') ++i;
+    }
+    return scratch;
+}
+
+// Добавить книги из CSV/TSV в конец списка. Первая строка пропускается,
+// если в ней нет года (заголовок столбцов). false — файл не открылся.
+bool importCsv(BookList& L, const std::string& filename, char delim, CsvStats& st) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) return false;
+    st = CsvStats();
+    L.titles = TitleIndex();   // пересоберётся при следующем поиске
+
+    std::string_view field[5];
+    std::string scratch[3];
+    size_t nf = 0, line = 0;
+    auto row = [&] {
+        ++line;
+        if (nf == 1 && (field[0].empty() || field[0] == "\r")) return;   // пустая строка
+        int y, pg;
+        if (nf == 5) {
+            std::string_view last = field[4];
+            if (!last.empty() && last.back() == '\r') last.remove_suffix(1);
+            if (parseIntField(csvValue(field[2], scratch[0]), y)
+                && parseIntField(csvValue(last, scratch[0]), pg)) {
+                addBack(L, newBook(L, csvValue(field[0], scratch[0]), csvValue(field[1], scratch[1]),
+                                   y, csvValue(field[3], scratch[2]), pg));
+                ++st.rows;
+                return;
+            }
+            if (line == 1) return;   // заголовок столбцов
+        }
+        if (!st.bad++) st.firstBad = line;
+    };
+
+    // buf всегда начинается с начала строки, поэтому вне кавычек;
+    // неполная строка в конце переносится в начало и читается заново
+    std::vector<char> buf(kCsvChunk + 64);
+    size_t have = 0;
+    bool eof = false;
+    while (!eof) {
+        if (buf.size() - 64 - have < kCsvChunk / 2) buf.resize(2 * buf.size());   // длинная строка
+        in.read(buf.data() + have, std::streamsize(buf.size() - 64 - have));
+        have += size_t(in.gcount());
+        st.bytes += uint64_t(in.gcount());
+        eof = !in;
+        if (eof && have && buf[have - 1] != '\n') buf[have++] = '\n';
+        std::memset(buf.data() + have, 0, 64);
+
+        size_t rowStart = 0, fieldStart = 0;
+        uint64_t carry = 0;   // ~0, если предыдущий шаг кончился внутри кавычек
+        nf = 0;
+        for (size_t base = 0; base < have; base += 64) {
+            uint64_t quotes, seps;
+            csvMasks(buf.data() + base, delim, quotes, seps);
+            uint64_t inside = prefixXor(quotes) ^ carry;
+            carry = uint64_t(int64_t(inside) >> 63);
+            for (uint64_t s = seps & ~inside; s; s &= s - 1) {
+                size_t pos = base + size_t(lowestBit(s));
+                if (nf < 5) field[nf] = std::string_view(buf.data() + fieldStart, pos - fieldStart);
+                ++nf;
+                fieldStart = pos + 1;
+                if (buf[pos] == '\n') {
+                    row();
+                    nf = 0;
+                    rowStart = pos + 1;
+                }
+            }
+        }
+        if (eof && rowStart < have) {   // незакрытая кавычка до конца файла
+            ++line;
+            if (!st.bad++) st.firstBad = line;
+            rowStart = have;
+        }
+        std::memmove(buf.data(), buf.data() + rowStart, have - rowStart);
+        have -= rowStart;
+    }
+    return true;
+}
+
+// Поле в кавычках, если в нём есть разделитель, кавычка или перевод строки
+void csvPut(std::string& out, std::string_view s, char delim) {
+    bool quote = false;
+    for (char c : s)
+        if (c == delim || c == '"' || c == '\n' || c == '\r') { quote = true; break; }
+    if (!quote) {
+        out.append(s.data(), s.size());
+        return;
+    }
+    out += '"';
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+void csvPutInt(std::string& out, int x) {
+    char tmp[16];
+    out.append(tmp, std::to_chars(tmp, tmp + sizeof(tmp), x).ptr);
+}
+
+// Выгрузить список в CSV/TSV одним буфером, сбрасываемым по kCsvChunk
+bool exportCsv(const BookList& L, const std::string& filename, char delim, CsvStats& st) {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) return false;
+    st = CsvStats();
+    std::string buf;
+    buf.reserve(kCsvChunk + 4096);
+    for (const char* h : {"title", "author", "year", "publisher", "pages"}) {
+        buf += h;
+        buf += delim;
+    }
+    buf.back() = '\n';
+    for (const BookNode* cur = L.head; cur; cur = cur->next) {
+        csvPut(buf, cur->title, delim);     buf += delim;
+        csvPut(buf, cur->author, delim);    buf += delim;
+        csvPutInt(buf, cur->year);          buf += delim;
+        csvPut(buf, cur->publisher, delim); buf += delim;
+        csvPutInt(buf, cur->pages);         buf += '\n';
+        ++st.rows;
+        if (buf.size() >= kCsvChunk) {
+            out.write(buf.data(), std::streamsize(buf.size()));
+            st.bytes += buf.size();
+            buf.clear();
+        }
+    }
+    out.write(buf.data(), std::streamsize(buf.size()));
+    st.bytes += buf.size();
+    return bool(out.flush());
+}
+
+// ==== Сортировка «пузырьком» по полям ====
+
+// key = 't' (title), 'a' (author), 'y' (year).
+// Узлы перевешиваются, а не обмениваются данными: id и индексы остаются
+// верны, а снимок фонового сохранения не портится.
+void sortList(BookList& L, char key) {
+    if (!L.head || !L.head->next) return;
+    bool swapped;
+    do {
+        swapped = false;
+        BookNode** link = &L.head;   // ссылка на текущий узел
+        while ((*link)->next) {
+            BookNode* cur = *link;
+            BookNode* nxt = cur->next;
+            bool need = false;
+            if (key=='t' && cur->title > nxt->title)        need = true;
+            if (key=='a' && cur->author > nxt->author)      need = true;
+            if (key=='y' && cur->year > nxt->year)          need = true;
+            if (need) {
+                cur->next = nxt->next;
+                nxt->next = cur;
+                *link = nxt;
+                swapped = true;
+            }
+            link = &(*link)->next;
+        }
+        L.tail = *link;
+    } while (swapped);
+    renumberList(L);
+    titleIndexReorder(L);
+    ++L.version;
+}
+
+// ==== Общий каталог для нескольких потоков ====
+//
+// SharedCatalog — обычный BookList, который меняет один писатель под
+// мьютексом, и опубликованный вид: узлы списка по порядку на некоторой
+// версии каталога. Читатель берёт текущий вид без блокировок и видит ровно
+// те книги, что были в каталоге на этой версии; изменения транзакции
+// write() становятся видны разом с новым видом. Узлы, выцепленные
+// транзакцией, и вытесненный ею вид освобождаются, когда ни один читатель
+// не может их держать (эпохи = версии каталога). Поля узлов после
+// вставки не меняются, а next и seq, которые писатель правит, читатели
+// не трогают: порядок они берут из вида.
+
+const uint64_t kIdle = UINT64_MAX;   // свободный слот читателя
+const int kReaderSlots = 64;
+
+class SharedCatalog {
+    struct View {
+        uint64_t version;
+        std::vector<const BookNode*> nodes;   // в порядке списка
+    };
+
+    // Остатки одной транзакции: свободны, когда все читатели дошли до epoch
+    struct Garbage {
+        uint64_t epoch;
+        std::unique_ptr<const View> view;
+        std::vector<BookNode*> nodes;
+    };
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> version{kIdle};
+    };
+
+    std::atomic<const View*> published{nullptr};
+    std::atomic<uint64_t> current{0};            // версия опубликованного вида
+    mutable ReaderSlot slots[kReaderSlots];
+    mutable std::mutex overflowLock;             // читатели, которым не хватило слота
+    mutable std::multiset<uint64_t> overflow;
+
+    std::mutex writeLock;
+    BookList list;
+    std::vector<BookNode*> removed;              // выцеплены открытой транзакцией
+    std::deque<Garbage> garbage;                 // по возрастанию epoch
+
+    // Минимальная версия, которую может держать читатель
+    uint64_t oldestReader() const {
+        uint64_t v = current.load();
+        for (const ReaderSlot& s : slots) v = std::min(v, s.version.load());
+        std::lock_guard<std::mutex> lock(overflowLock);
+        if (!overflow.empty()) v = std::min(v, *overflow.begin());
+        return v;
+    }
+
+    View* makeView() const {
+        View* v = new View{list.version, {}};
+        v->nodes.reserve(list.count);
+        for (const BookNode* n = list.head; n; n = n->next) v->nodes.push_back(n);
+        return v;
+    }
+
+    // Новый вид, если список изменился; прежний вид и выцепленные узлы — в мусор
+    void publish() {
+        if (list.version == current.load(std::memory_order_relaxed)) return;
+        const View* old = published.exchange(makeView());
+        current.store(list.version);
+        garbage.push_back({list.version, std::unique_ptr<const View>(old), std::move(removed)});
+        removed.clear();
+    }
+
+    void reclaim() {
+        uint64_t oldest = oldestReader();
+        while (!garbage.empty() && garbage.front().epoch <= oldest) {
+            for (BookNode* n : garbage.front().nodes) freeBook(list, n);
+            garbage.pop_front();
+        }
+    }
+
+public:
+    SharedCatalog() : SharedCatalog(BookList()) {}
+
+    // Каталог забирает книги списка L (фоновое сохранение L должно быть закончено)
+    explicit SharedCatalog(BookList&& L) : list(std::move(L)) {
+        L = BookList();
+        current.store(list.version);
+        published.store(makeView());
+    }
+
+    SharedCatalog(const SharedCatalog&) = delete;
+    SharedCatalog& operator=(const SharedCatalog&) = delete;
+
+    ~SharedCatalog() { delete published.load(); }
+
+    // Снимок каталога; пока он жив, его книги не освобождаются
+    class Snapshot {
+        const SharedCatalog* cat;
+        std::atomic<uint64_t>* slot = nullptr;   // nullptr — записан в overflow
+        uint64_t pinned = 0;                     // версия, под которой записан читатель
+        const View* view;
+    public:
+        explicit Snapshot(const SharedCatalog& c) : cat(&c) {
+            // Версия записывается до чтения вида: писатель, опубликовавший
+            // вид позже, либо увидит запись, либо вид уже новый
+            static thread_local unsigned hint = 0;
+            for (int k = 0; k < kReaderSlots; ++k) {
+                unsigned i = (hint + k) % kReaderSlots;
+                uint64_t idle = kIdle;
+                pinned = c.current.load();
+                if (c.slots[i].version.compare_exchange_strong(idle, pinned)) {
+                    slot = &c.slots[i].version;
+                    hint = i;
+                    break;
+                }
+            }
+            if (!slot) {
+                std::lock_guard<std::mutex> lock(c.overflowLock);
+                pinned = c.current.load();
+                c.overflow.insert(pinned);
+            }
+            view = c.published.load();
+        }
+        ~Snapshot() {
+            if (slot) {
+                slot->store(kIdle, std::memory_order_release);
+                return;
+            }
+            std::lock_guard<std::mutex> lock(cat->overflowLock);
+            cat->overflow.erase(cat->overflow.find(pinned));
+        }
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        uint64_t version() const { return view->version; }
+        size_t count() const { return view->nodes.size(); }
+
+        template <class Visit>
+        void forEach(Visit visit) const {
+            for (const BookNode* n : view->nodes) visit(*n);
+        }
+
+        const BookNode* findByTitle(const std::string& key) const {
+            for (const BookNode* n : view->nodes)
+                if (n->title == key) return n;
+            return nullptr;
+        }
+    };
+
+    Snapshot snapshot() const { return Snapshot(*this); }
+
+    // Изменения внутри одной транзакции write(): обычные операции списка,
+    // только выцепленные узлы живут, пока их могут видеть читатели
+    class Writer {
+        SharedCatalog& c;
+    public:
+        explicit Writer(SharedCatalog& cat) : c(cat) {}
+
+        void addFront(std::string_view t, std::string_view a, int y, std::string_view pub, int p) {
+            ::addFront(c.list, newBook(c.list, t, a, y, pub, p));
+        }
+
+        void addBack(std::string_view t, std::string_view a, int y, std::string_view pub, int p) {
+            ::addBack(c.list, newBook(c.list, t, a, y, pub, p));
+        }
+
+        // Первая книга с таким заголовком исчезнет из новых снимков
+        bool removeByTitle(const std::string& key) {
+            BookNode* n = unlinkByTitle(c.list, key);
+            if (n) c.removed.push_back(n);
+            return n != nullptr;
+        }
+
+        // Первая по списку книга с таким заголовком (по индексу заголовков)
+        const BookNode* find(const std::string& key) { return ::findByTitle(c.list, key); }
+    };
+
+    // Выполнить изменения f(Writer&) одной транзакцией
+    template <class F>
+    void write(F f) {
+        std::lock_guard<std::mutex> lock(writeLock);
+        Writer w(*this);
+        f(w);
+        publish();
+        reclaim();
+    }
+
+    // Вернуть список, оставив каталог пустым. Живых снимков быть не должно.
+    BookList release() {
+        std::lock_guard<std::mutex> lock(writeLock);
+        reclaim();
+        BookList L = std::move(list);
+        list = BookList();
+        list.version = L.version + 1;
+        publish();
+        reclaim();
+        return L;
+    }
+
+    // Узлов и видов, ещё не освобождённых
+    size_t pendingFree() {
+        std::lock_guard<std::mutex> lock(writeLock);
+        size_t n = 0;
+        for (const Garbage& g : garbage) n += 1 + g.nodes.size();
+        return n;
+    }
 };
 
-// Головной элемент списка
-struct BookList {
-    BookNode* head;
-    size_t count;
-    BookList() : head(nullptr), count(0) {}
+// ==== Синтетический каталог ====
+//
+// Детерминированный по seed генератор книг с перекосами, как в настоящем
+// каталоге: авторы, издательства и слова заголовков распределены по Ципфу,
+// длина заголовка — от 1 до 12 слов (чаще 1–3), годы собраны вокруг
+// нескольких пиков, число страниц — логнормально около 250. Случайные
+// величины выводятся из mt19937 вручную, поэтому выборка одинакова
+// с любой стандартной библиотекой.
+
+// Равномерно в (0, 1)
+double unitRandom(std::mt19937& rng) {
+    return (double(rng()) + 0.5) / 4294967296.0;
+}
+
+// Нормальное распределение (Бокс — Мюллер)
+double normalRandom(std::mt19937& rng, double mean, double sigma) {
+    double u = unitRandom(rng), v = unitRandom(rng);
+    return mean + sigma * std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * v);
+}
+
+// Распределение Ципфа на {0, …, k − 1}: P(i) ~ 1 / (i + 1)^s
+struct Zipf {
+    std::vector<double> cdf;
+
+    Zipf(size_t k, double s) : cdf(k) {
+        double sum = 0;
+        for (size_t i = 0; i < k; ++i) cdf[i] = sum += std::pow(double(i + 1), -s);
+        for (double& c : cdf) c /= sum;
+    }
+
+    size_t operator()(std::mt19937& rng) const {
+        size_t i = size_t(std::upper_bound(cdf.begin(), cdf.end(), unitRandom(rng)) - cdf.begin());
+        return std::min(i, cdf.size() - 1);
+    }
 };
 
-// Вспомогательный ввод целого числа
-int readInt(const std::string& prompt) {
-    int x;
-    while (true) {
-        std::cout << prompt;
-        if (std::cin >> x) {
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            return x;
+// Случайное «слово» из русских слогов
+std::string syntheticWord(std::mt19937& rng) {
+    static const char* cons[] = {"б", "в", "г", "д", "ж", "з", "к", "л", "м", "н",
+                                 "п", "р", "с", "т", "ф", "х", "ц", "ч", "ш", "щ"};
+    static const char* vow[]  = {"а", "е", "и", "о", "у", "ы", "э", "ю", "я", "ё"};
+    std::string w;
+    int n = 1 + int(rng() % 4);
+    for (int i = 0; i < n; ++i) {
+        w += cons[rng() % 20];
+        w += vow[rng() % 10];
+    }
+    if (rng() % 2) w += cons[rng() % 20];
+    return w;
+}
+
+// Добавить в конец списка n синтетических книг (детерминированно по seed).
+// Индекс заголовков сбрасывается и пересоберётся при следующем поиске.
+void makeSyntheticBooks(BookList& L, size_t n, uint32_t seed) {
+    struct YearPeak { double weight, mean, sigma; };
+    static const YearPeak peaks[] = {
+        {0.10, 1890, 20}, {0.25, 1965, 12}, {0.30, 1995, 8}, {0.35, 2015, 5}};
+
+    std::mt19937 rng(seed);
+    std::vector<std::string> vocab(20000);
+    for (std::string& w : vocab) w = syntheticWord(rng);
+    std::vector<std::string> authors(std::max<size_t>(300, n / 20));
+    for (std::string& a : authors) a = vocab[rng() % vocab.size()] + " " + vocab[rng() % vocab.size()];
+    std::vector<std::string> publishers(200);
+    for (std::string& p : publishers) p = "Изд-во " + vocab[rng() % vocab.size()];
+    Zipf word(vocab.size(), 1.0), author(authors.size(), 1.1), publisher(publishers.size(), 1.3);
+
+    L.titles = TitleIndex();
+    std::string t;
+    for (size_t i = 0; i < n; ++i) {
+        t.clear();
+        int words = 1 + int(std::min(11.0, -std::log(unitRandom(rng)) * 1.8));
+        for (int j = 0; j < words; ++j) {
+            if (j) t += ' ';
+            t += vocab[word(rng)];
         }
-        std::cout << "Неверный ввод, попробуйте ещё раз.\n";
-        std::cin.clear();
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        double pick = unitRandom(rng);
+        const YearPeak* pk = peaks;
+        while (pick > pk->weight && pk + 1 != std::end(peaks)) pick -= pk++->weight;
+        int y = int(std::clamp(normalRandom(rng, pk->mean, pk->sigma), 1800.0, 2025.0));
+        int pg = int(std::clamp(std::exp(normalRandom(rng, std::log(250.0), 0.5)), 16.0, 3000.0));
+        addBack(L, newBook(L, t, authors[author(rng)], y, publishers[publisher(rng)], pg));
     }
 }
 
-// ==== Базовые операции с узлами ====
+// ==== Замеры производительности (запуск: Z7 --bench [N] [замер]) ====
 
-// Добавить в начало
-void addFront(BookList& L, BookNode* node) {
-    node->next = L.head;
-    L.head = node;
-    ++L.count;
+double secondsSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
 }
 
-// Добавить в конец
-void addBack(BookList& L, BookNode* node) {
-    if (!L.head) {
-        L.head = node;
-    } else {
-        BookNode* cur = L.head;
-        while (cur->next) cur = cur->next;
-        cur->next = node;
-    }
-    ++L.count;
+// Пиковый размер резидентной памяти процесса, МБ (0, если неизвестен)
+double peakRssMb() {
+#ifdef __unix__
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss / 1024.0;
+#else
+    return 0.0;
+#endif
 }
 
-// Добавить после элемента с данным заголовком
-bool addAfter(BookList& L, const std::string& keyTitle, BookNode* node) {
-    for (BookNode* cur = L.head; cur; cur = cur->next) {
-        if (cur->title == keyTitle) {
-            node->next = cur->next;
-            cur->next = node;
-            ++L.count;
-            return true;
-        }
+void benchTitleIndex(size_t n) {
+    BookList L;
+    makeSyntheticBooks(L, n, 42);
+
+    auto t0 = std::chrono::steady_clock::now();
+    titleIndexBuild(L);
+    double build = secondsSince(t0);
+    size_t bytes = titleIndexBytes(L.titles);
+
+    std::mt19937 rng(7);
+    const int Q = 2000;
+    std::vector<std::string> frags, prefixes;
+    for (int i = 0; i < Q; ++i) {
+        const std::string t = L.byId[rng() % L.byId.size()]->title.str();
+        // фрагмент в 3–6 символов из середины, префикс в 3 символа
+        std::vector<size_t> starts;
+        for (size_t j = 0; j < t.size(); ++j)
+            if ((t[j] & 0xC0) != 0x80) starts.push_back(j);
+        starts.push_back(t.size());
+        size_t chars = starts.size() - 1;
+        size_t len = std::min<size_t>(chars, 3 + rng() % 4);
+        size_t from = (chars - len) / 2;
+        frags.push_back(t.substr(starts[from], starts[from + len] - starts[from]));
+        prefixes.push_back(t.substr(0, starts[std::min<size_t>(chars, 3)]));
     }
-    return false;
+
+    size_t found = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (const std::string& f : frags) found += searchTitle(L, f, 10).size();
+    double sub = secondsSince(t0) / Q;
+    t0 = std::chrono::steady_clock::now();
+    for (const std::string& p : prefixes) found += findByTitlePrefix(L, p, 10).size();
+    double pre = secondsSince(t0) / Q;
+
+    t0 = std::chrono::steady_clock::now();
+    const int A = 10000;
+    for (int i = 0; i < A; ++i)
+        addFront(L, newBook(L, "Новая книга " + std::to_string(i), "Автор", 2024, "Изд", 100));
+    double add = secondsSince(t0) / A;
+
+    std::cout << "Индекс заголовков, книг: " << n << "\n"
+              << "  сборка:            " << build * 1e3 << " мс\n"
+              << "  объём:             " << bytes / (1024.0 * 1024.0) << " МБ ("
+              << double(bytes) / n << " байт/книга)\n"
+              << "  поиск подстроки:   " << sub * 1e6 << " мкс/запрос\n"
+              << "  поиск префикса:    " << pre * 1e6 << " мкс/запрос\n"
+              << "  добавление:        " << add * 1e6 << " мкс/книга\n"
+              << "  (найдено всего: " << found << ")\n";
+    clearList(L);
 }
 
-// Удалить по заголовку (первое вхождение)
-bool removeByTitle(BookList& L, const std::string& keyTitle) {
-    BookNode* cur = L.head;
-    BookNode* prev = nullptr;
-    while (cur) {
-        if (cur->title == keyTitle) {
-            if (!prev) L.head = cur->next;
-            else       prev->next = cur->next;
-            delete cur;
-            --L.count;
-            return true;
-        }
-        prev = cur;
-        cur  = cur->next;
+void benchYearIndex(size_t n) {
+    BookList L;
+    makeSyntheticBooks(L, n, 42);
+    auto t0 = std::chrono::steady_clock::now();
+    yearIndexBuild(L);
+    std::cout << "Индекс по году, книг: " << n << "\n"
+              << "  сборка: " << secondsSince(t0) * 1e3 << " мс, блоков: "
+              << L.years.blocks.size() << "\n"
+              << "  диапазон      сумма/ср. стр.: проход / индекс     10 главных авторов: проход / индекс\n";
+
+    const int R = 20;
+    const int ranges[][2] = {{1950, 1950}, {1960, 1969}, {1900, 1949}, {1900, 2024}};
+    for (const auto& r : ranges) {
+        int lo = r[0], hi = r[1];
+        YearStats scan, idx;
+        t0 = std::chrono::steady_clock::now();
+        for (BookNode* cur = L.head; cur; cur = cur->next)
+            if (cur->year >= lo && cur->year <= hi) { ++scan.count; scan.pages += cur->pages; }
+        double tScan = secondsSince(t0);
+        t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < R; ++i) idx = yearRangeStats(L, lo, hi);
+        double tIdx = secondsSince(t0) / R;
+
+        t0 = std::chrono::steady_clock::now();
+        std::unordered_map<std::string, size_t> byAuthor;
+        for (BookNode* cur = L.head; cur; cur = cur->next)
+            if (cur->year >= lo && cur->year <= hi) ++byAuthor[cur->author.str()];
+        double tScanA = secondsSince(t0);
+        size_t authors = 0;
+        t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < R; ++i) authors = authorCountsInRange(L, lo, hi, 10).size();
+        double tIdxA = secondsSince(t0) / R;
+
+        std::cout << "  " << lo << "–" << hi << "     "
+                  << tScan * 1e3 << " мс / " << tIdx * 1e3 << " мс"
+                  << "     " << tScanA * 1e3 << " мс / " << tIdxA * 1e3 << " мс"
+                  << (scan.count == idx.count && scan.pages == idx.pages
+                      && std::min<size_t>(byAuthor.size(), 10) == authors ? "" : "  РАСХОЖДЕНИЕ!") << "\n";
     }
-    return false;
+    clearList(L);
 }
 
-// Поиск по заголовку (возвращает указатель или nullptr)
-BookNode* findByTitle(BookList& L, const std::string& key) {
-    for (BookNode* cur = L.head; cur; cur = cur->next)
-        if (cur->title == key)
-            return cur;
-    return nullptr;
+// Повторные запросы по автору и году: первый проход считает, второй берёт
+// из кэша, третий — после добавления книги, когда кэш сброшен
+void benchQueryCache(size_t n) {
+    BookList L;
+    makeSyntheticBooks(L, n, 42);
+    const size_t Q = 100;
+    std::vector<std::string> authors;
+    std::vector<int> years;
+    for (size_t i = 0; i < Q; ++i) {
+        const BookNode* b = L.byId[i * 7919 % L.byId.size()];
+        authors.push_back(b->author.str());
+        years.push_back(b->year);
+    }
+    ensureYearIndex(L);
+
+    size_t found = 0;
+    auto pass = [&](double& tAuthor, double& tYear) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (const std::string& a : authors) found += booksByAuthor(L, a)->size();
+        tAuthor = secondsSince(t0) / Q;
+        t0 = std::chrono::steady_clock::now();
+        for (int y : years) found += booksByYear(L, y)->size();
+        tYear = secondsSince(t0) / Q;
+    };
+    double coldA, coldY, warmA, warmY, afterA, afterY;
+    pass(coldA, coldY);
+    pass(warmA, warmY);
+    addBack(L, newBook(L, "Новая книга", authors[0], years[0], "Издательство", 100));
+    pass(afterA, afterY);
+
+    const QueryCache& C = L.queries;
+    std::cout << "Кэш запросов, книг: " << n << ", запросов в проходе: " << Q << " + " << Q << "\n"
+              << "  мкс/запрос: первый / из кэша / после изменения\n"
+              << "  по автору: " << coldA * 1e6 << " / " << warmA * 1e6 << " / " << afterA * 1e6 << "\n"
+              << "  по году:   " << coldY * 1e6 << " / " << warmY * 1e6 << " / " << afterY * 1e6 << "\n"
+              << "  попаданий " << C.hits << ", промахов " << C.misses << ", вытеснено " << C.evictions
+              << ", сбросов " << C.invalidations << ", занято " << C.bytes / 1024 << " КБ"
+              << " (найдено всего " << found << ")\n";
+    clearList(L);
 }
 
-// Вывод по автору
-void findByAuthor(BookList& L, const std::string& key) {
-    bool found = false;
-    for (BookNode* cur = L.head; cur; cur = cur->next) {
-        if (cur->author == key) {
-            std::cout << "  «" << cur->title << "», "
-                      << cur->year << ", " << cur->publisher
-                      << ", " << cur->pages << " стр.\n";
-            found = true;
+// Нагрузочная проверка на книгах списка L: писатель добавляет и удаляет
+// в одной транзакции пары пометочных книг, читатели проверяют, что пары
+// в снимке всегда целые и поля узлов не испорчены, и ищут книги L по
+// заголовку. В конце пометочные книги удаляются, и L возвращается тем же.
+// Возвращает число нарушений.
+size_t stressSharedCatalog(BookList& L, int readers, double seconds) {
+    const std::string mark = "[проверка каталога]";
+    std::vector<std::string> titles;
+    for (const BookNode* cur = L.head; cur; cur = cur->next) titles.push_back(cur->title.str());
+    size_t books = titles.size();
+    SharedCatalog cat(std::move(L));
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> errors{0}, snapshots{0};
+
+    std::vector<std::thread> pool;
+    for (int r = 0; r < readers; ++r) {
+        pool.emplace_back([&, r] {
+            std::mt19937 rng(r);
+            while (!stop.load()) {
+                SharedCatalog::Snapshot s = cat.snapshot();
+                std::unordered_map<int, int> halves;
+                size_t others = 0;
+                s.forEach([&](const BookNode& b) {
+                    if (b.publisher != mark) {
+                        ++others;
+                        return;
+                    }
+                    if (b.pages != b.year * 7 || b.author != "Автор " + std::to_string(b.year))
+                        ++errors;
+                    ++halves[b.year];
+                });
+                for (const auto& kv : halves)
+                    if (kv.second != 2) ++errors;
+                if (others != books) ++errors;
+                if (!titles.empty() && !s.findByTitle(titles[rng() % titles.size()])) ++errors;
+                ++snapshots;
+            }
+        });
+    }
+
+    std::mt19937 rng(1);
+    std::vector<int> live;
+    auto title = [&](int y, const char* half) { return mark + " " + std::to_string(y) + half; };
+    auto t0 = std::chrono::steady_clock::now();
+    int next = 0;
+    size_t tx = 0;
+    while (secondsSince(t0) < seconds) {
+        if (live.size() < 200 || rng() % 2) {
+            int y = next++;
+            cat.write([&](SharedCatalog::Writer& w) {
+                w.addFront(title(y, "a"), "Автор " + std::to_string(y), y, mark, y * 7);
+                w.addBack (title(y, "b"), "Автор " + std::to_string(y), y, mark, y * 7);
+            });
+            live.push_back(y);
+        } else {
+            size_t i = rng() % live.size();
+            int y = live[i];
+            live[i] = live.back();
+            live.pop_back();
+            cat.write([&](SharedCatalog::Writer& w) {
+                w.removeByTitle(title(y, "a"));
+                w.removeByTitle(title(y, "b"));
+            });
         }
+        ++tx;
     }
-    if (!found) std::cout << "Не найдено книг автора «" << key << "»\n";
+    stop = true;
+    for (std::thread& t : pool) t.join();
+    cat.write([&](SharedCatalog::Writer& w) {
+        for (int y : live) {
+            w.removeByTitle(title(y, "a"));
+            w.removeByTitle(title(y, "b"));
+        }
+    });
+    // без читателей всё удалённое уже должно быть освобождено
+    errors += cat.pendingFree();
+    L = cat.release();
+    if (L.count != books) ++errors;
+    std::cout << "Проверка общего каталога: книг " << books << ", читателей " << readers
+              << ", транзакций " << tx << ", снимков " << snapshots
+              << ", нарушений " << errors << "\n";
+    return errors;
 }
 
-// Вывод по году
-void findByYear(BookList& L, int key) {
-    bool found = false;
-    for (BookNode* cur = L.head; cur; cur = cur->next) {
-        if (cur->year == key) {
-            std::cout << "  «" << cur->title << "», "
-                      << cur->author << ", " << cur->publisher
-                      << ", " << cur->pages << " стр.\n";
-            found = true;
+// Пропускная способность общего каталога: 95% поисков по заголовку
+// в снимке, 5% транзакций «перенести книгу в конец»
+void benchSharedCatalog(size_t n) {
+    BookList L;
+    makeSyntheticBooks(L, n, 42);
+    std::vector<std::string> titles;
+    for (BookNode* cur = L.head; cur; cur = cur->next) titles.push_back(cur->title.str());
+    SharedCatalog cat(std::move(L));
+
+    std::cout << "Общий каталог, книг: " << n << ", смесь 95/5 чтение/запись\n";
+    for (int threads : {1, 2, 4, 8, 16, 32}) {
+        std::atomic<bool> stop{false};
+        std::atomic<size_t> ops{0};
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([&, t] {
+                std::mt19937 rng(1000 + t);
+                size_t done = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    const std::string& key = titles[rng() % titles.size()];
+                    if (rng() % 100 < 5) {
+                        cat.write([&](SharedCatalog::Writer& w) {
+                            // узел выцепленной книги жив до конца транзакции
+                            if (const BookNode* b = w.find(key)) {
+                                w.removeByTitle(key);
+                                w.addBack(b->title, b->author, b->year, b->publisher, b->pages);
+                            }
+                        });
+                    } else {
+                        SharedCatalog::Snapshot s = cat.snapshot();
+                        bench::DoNotOptimize(s.findByTitle(key));
+                    }
+                    ++done;
+                }
+                ops += done;
+            });
         }
+        auto t0 = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        stop = true;
+        for (std::thread& th : pool) th.join();
+        std::cout << "  потоков " << threads << ": "
+                  << size_t(ops / secondsSince(t0)) << " оп/с\n";
     }
-    if (!found) std::cout << "Не найдено книг за " << key << " год\n";
 }
 
-// Вывести весь список
-void printList(const BookList& L) {
-    std::cout << "Всего книг: " << L.count << "\n";
-    size_t idx = 1;
-    for (BookNode* cur = L.head; cur; cur = cur->next, ++idx) {
-        std::cout << idx << ") «" << cur->title << "», "
-                  << cur->author << ", " << cur->year << ", "
-                  << cur->publisher << ", " << cur->pages << " стр.\n";
+// Загрузка, очистка и пиковая память. Пик — на весь процесс,
+// поэтому точен при отдельном запуске: Z7 --bench N load
+void benchLoadTeardown(size_t n) {
+    const std::string file = "bench_books.bin";
+    {
+        BookList L;
+        makeSyntheticBooks(L, n, 42);
+        saveToFile(L, file);
     }
+    BookList L;
+    auto t0 = std::chrono::steady_clock::now();
+    loadFromFile(L, file);
+    double load = secondsSince(t0);
+    double rss = peakRssMb();
+    t0 = std::chrono::steady_clock::now();
+    clearList(L);
+    double teardown = secondsSince(t0);
+    std::remove(file.c_str());
+    std::cout << "Загрузка/очистка, книг: " << n << "\n"
+              << "  загрузка: " << load * 1e3 << " мс\n"
+              << "  очистка:  " << teardown * 1e3 << " мс\n"
+              << "  пик памяти: " << rss << " МБ\n";
 }
 
-// ==== Сохранение/загрузка в бинарный файл ====
-
-// Сравнение узлов (все поля)
-bool equals(const BookNode* A, const BookNode* B) {
-    return A->title     == B->title
-        && A->author    == B->author
-        && A->year      == B->year
-        && A->publisher == B->publisher
-        && A->pages     == B->pages;
+// Блочный файл: запись и чтение на 1, 2, 4… потоках
+void benchBlockFile(size_t n) {
+    const std::string file = "bench_books.bin";
+    BookList L;
+    makeSyntheticBooks(L, n, 42);
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Блочный файл, книг: " << n << ", ядер: " << cores << "\n";
+    for (unsigned t = 1; t <= std::max(4u, cores); t *= 2) {
+        auto t0 = std::chrono::steady_clock::now();
+        writeBookFile(listNodes(L), file, t);
+        double save = secondsSince(t0);
+        std::ifstream probe(file, std::ios::binary | std::ios::ate);
+        double mb = double(probe.tellg()) / (1 << 20);
+        BookList M;
+        std::ifstream in(file, std::ios::binary);
+        t0 = std::chrono::steady_clock::now();
+        bool ok = readBookFile(M, in, file, t);
+        double load = secondsSince(t0);
+        std::cout << "  потоков " << t << ": запись " << save * 1e3 << " мс ("
+                  << mb / save << " МБ/с), чтение " << load * 1e3 << " мс ("
+                  << mb / load << " МБ/с)" << (ok && M.count == n ? "" : " ОШИБКА") << "\n";
+    }
+    std::remove(file.c_str());
 }
 
-// Сохранить весь список в файл (перезапись)
-void saveToFile(const BookList& L, const std::string& filename) {
-    std::ofstream out(filename, std::ios::binary);
-    if (!out) {
-        std::cerr << "Не удалось открыть файл для записи\n";
-        return;
-    }
-    out.write(reinterpret_cast<const char*>(&L.count), sizeof(L.count));
-    for (BookNode* cur = L.head; cur; cur = cur->next) {
-        auto wrs = [&](const std::string& s){
-            uint32_t len = uint32_t(s.size());
-            out.write(reinterpret_cast<const char*>(&len), sizeof(len));
-            out.write(s.data(), len);
-        };
-        wrs(cur->title);
-        wrs(cur->author);
-        out.write(reinterpret_cast<const char*>(&cur->year), sizeof(cur->year));
-        wrs(cur->publisher);
-        out.write(reinterpret_cast<const char*>(&cur->pages), sizeof(cur->pages));
+// Фоновое сохранение под потоком правок: сколько стоит снимок и сколько
+// правок успевает пройти, пока файл пишется
+void benchAsyncSave(size_t n) {
+    const std::string file = "bench_books.bin";
+    BookList L;
+    makeSyntheticBooks(L, n, 42);
+    auto t0 = std::chrono::steady_clock::now();
+    startAsyncSave(L, file);
+    double start = secondsSince(t0);
+    size_t edits = 0;
+    while (!L.saving->done) {
+        addFront(L, newBook(L, "правка", "автор", 2000, "изд", 1));
+        removeByTitle(L, "правка");
+        edits += 2;
     }
-    std::cout << "Сохранено в «" << filename << "» (" << L.count << " книг)\n";
+    double total = secondsSince(t0);
+    finishAsyncSave(L, true);
+    BookList M;
+    loadFromFile(M, file);
+    std::remove(file.c_str());
+    std::cout << "Фоновое сохранение, книг: " << n << "\n"
+              << "  снимок: " << start * 1e3 << " мс\n"
+              << "  запись: " << total * 1e3 << " мс, правок за это время: " << edits << "\n"
+              << "  в файле книг: " << M.count << (M.count == n ? "" : " ОШИБКА") << "\n";
 }
 
-// Загрузить из файла (полная перезагрузка списка)
-void loadFromFile(BookList& L, const std::string& filename) {
-    // очистка текущего
-    while (L.head) {
-        BookNode* tmp = L.head;
-        L.head = L.head->next;
-        delete tmp;
-    }
-    L.count = 0;
+// Экспорт и импорт CSV
+void benchCsv(size_t n) {
+    const std::string file = "bench_books.csv";
+    BookList L;
+    makeSyntheticBooks(L, n, 42);
+    CsvStats out, in;
+    auto t0 = std::chrono::steady_clock::now();
+    exportCsv(L, file, ',', out);
+    double exp = secondsSince(t0);
+    BookList M;
+    t0 = std::chrono::steady_clock::now();
+    importCsv(M, file, ',', in);
+    double imp = secondsSince(t0);
+    std::remove(file.c_str());
+    double mb = double(out.bytes) / (1 << 20);
+    std::cout << "CSV, книг: " << n << ", файл " << mb << " МБ\n"
+              << "  экспорт: " << exp * 1e3 << " мс, " << mb / exp << " МБ/с\n"
+              << "  импорт:  " << imp * 1e3 << " мс, " << mb / imp << " МБ/с, "
+              << size_t(in.rows / imp) << " строк/с"
+              << (in.rows == n && !in.bad ? "" : " ОШИБКА") << "\n";
+}
 
-    std::ifstream in(filename, std::ios::binary);
-    if (!in) {
-        std::cerr << "Не удалось открыть файл для чтения\n";
-        return;
+// Размер файла, байт
+uint64_t fileBytes(const std::string& file) {
+    std::ifstream in(file, std::ios::binary | std::ios::ate);
+    return in ? uint64_t(in.tellg()) : 0;
+}
+
+// Сжатые форматы против обычного блочного: степень сжатия, скорость
+// распаковки и сравнение с простым чтением несжатого файла
+void benchPackedFile(size_t n) {
+    const std::string file = "bench_books.bin";
+    std::vector<const BookNode*> nodes;
+    BookList L;
+    makeSyntheticBooks(L, n, 42);
+    nodes = listNodes(L);
+
+    writeBookFile(nodes, file, 0);
+    uint64_t plain = fileBytes(file);
+    std::string raw(plain, '\0');
+    auto t0 = std::chrono::steady_clock::now();
+    std::ifstream(file, std::ios::binary).read(&raw[0], std::streamsize(plain));
+    double readPlain = secondsSince(t0);
+    std::cout << "Сжатый формат, книг: " << n << "\n"
+              << "  чтение несжатого файла (" << plain / double(1 << 20) << " МБ) без разбора: "
+              << readPlain * 1e3 << " мс\n";
+
+    const char* names[] = {"блочный", "словарь", "словарь+LZ"};
+    for (BookFormat fmt : {BookFormat::Plain, BookFormat::Packed, BookFormat::PackedLz}) {
+        t0 = std::chrono::steady_clock::now();
+        writeBookFile(nodes, file, 0, nullptr, fmt);
+        double save = secondsSince(t0);
+        uint64_t bytes = fileBytes(file);
+        BookList M;
+        std::ifstream in(file, std::ios::binary);
+        t0 = std::chrono::steady_clock::now();
+        bool ok = readBookFile(M, in, file, 0);
+        double load = secondsSince(t0);
+        std::cout << "  " << names[int(fmt)] << ": " << bytes / double(1 << 20) << " МБ, сжатие "
+                  << double(plain) / bytes << "x, запись " << save * 1e3 << " мс, загрузка "
+                  << load * 1e3 << " мс (" << plain / double(1 << 20) / load
+                  << " МБ/с несжатых)" << (ok && M.count == n ? "" : " ОШИБКА") << "\n";
     }
+    std::remove(file.c_str());
+}
+
+// Одна операция полного прогона
+struct OpTiming {
+    std::string op;
+    size_t reps;
+    double seconds;
+    std::string skipped;   // почему не замерялась (пусто, если замерялась)
+};
+
+struct SuiteRun {
     size_t n;
-    in.read(reinterpret_cast<char*>(&n), sizeof(n));
-    for (size_t i = 0; i < n; ++i) {
-        auto rds = [&](void)->std::string {
-            uint32_t len;
-            in.read(reinterpret_cast<char*>(&len), sizeof(len));
-            std::string s(len, '\0');
-            in.read(&s[0], len);
-            return s;
-        };
-        std::string t = rds();
-        std::string a = rds();
-        int y; in.read(reinterpret_cast<char*>(&y), sizeof(y));
-        std::string p = rds();
-        int pg; in.read(reinterpret_cast<char*>(&pg), sizeof(pg));
-        addBack(L, new BookNode(t,a,y,p,pg));
+    uint64_t fileBytes;
+    double peakRssMb;
+    std::vector<OpTiming> ops;
+};
+
+const size_t kQuadraticLimit = 10000;   // дальше пузырёк и слияние идут часами
+
+// Все операции каталога на n синтетических книгах
+SuiteRun benchAllOps(size_t n, uint32_t seed) {
+    const std::string file = "bench_suite.bin";
+    SuiteRun run{n, 0, 0, {}};
+    auto timed = [&](const char* op, size_t reps, auto body) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < reps; ++i) body(i);
+        run.ops.push_back({op, reps, secondsSince(t0), ""});
+    };
+    auto quadratic = [&](const char* op, auto body) {
+        if (n <= kQuadraticLimit) timed(op, 1, body);
+        else run.ops.push_back({op, 0, 0, "O(n^2), только до " + std::to_string(kQuadraticLimit)});
+    };
+
+    BookList L;
+    timed("generate", 1, [&](size_t) { makeSyntheticBooks(L, n, seed); });
+
+    // ключи запросов — поля случайных существующих книг
+    const size_t keys = 1000;
+    std::mt19937 rng(seed + 1);
+    std::vector<std::string> titles, authors;
+    std::vector<int> years;
+    for (size_t i = 0; i < keys; ++i) {
+        const BookNode* b = L.byId[rng() % L.byId.size()];
+        titles.push_back(b->title.str());
+        authors.push_back(b->author.str());
+        years.push_back(b->year);
     }
-    std::cout << "Загружено из «" << filename << "» (" << L.count << " книг)\n";
+    size_t scans = std::clamp<size_t>(10000000 / n, 3, keys);   // для операций с проходом по списку
+    size_t sink = 0;
+    auto count = [&](const BookNode&) { ++sink; };
+
+    timed("title_index_build", 1, [&](size_t) { ensureTitleIndex(L); });
+    timed("find_title", keys, [&](size_t i) { sink += findByTitle(L, titles[i]) != nullptr; });
+    timed("find_author", scans, [&](size_t i) { forEachByAuthor(L, authors[i], count); });
+    timed("year_index_build", 1, [&](size_t) { ensureYearIndex(L); });
+    timed("find_year", keys, [&](size_t i) { findByYearRange(L, years[i], years[i], count); });
+
+    quadratic("sort_title",  [&](size_t) { sortList(L, 't'); });
+    quadratic("sort_author", [&](size_t) { sortList(L, 'a'); });
+    quadratic("sort_year",   [&](size_t) { sortList(L, 'y'); });
+
+    timed("save", 1, [&](size_t) { replaceBookFile(listNodes(L), file, 0); });
+    run.fileBytes = fileBytes(file);
+    timed("save_packed", 1, [&](size_t) {
+        replaceBookFile(listNodes(L), file + ".z", 0, nullptr, BookFormat::PackedLz);
+    });
+    clearList(L);
+    timed("load", 1, [&](size_t) {
+        std::ifstream in(file, std::ios::binary);
+        readBookFile(L, in, file, 0);
+    });
+    clearList(L);
+    timed("load_packed", 1, [&](size_t) {
+        std::ifstream in(file + ".z", std::ios::binary);
+        readBookFile(L, in, file + ".z", 0);
+    });
+    quadratic("merge", [&](size_t) { mergeFromFile(L, file); });
+
+    timed("add_front", 10 * keys, [&](size_t i) {
+        addFront(L, newBook(L, "новинка " + std::to_string(i), authors[i % keys], 2024, "Изд-во", 100));
+    });
+    timed("add_back", 10 * keys, [&](size_t i) {
+        addBack(L, newBook(L, "допечатка " + std::to_string(i), authors[i % keys], 2024, "Изд-во", 100));
+    });
+    timed("add_after", scans, [&](size_t i) {
+        BookNode* b = newBook(L, "вставка " + std::to_string(i), authors[i], 2024, "Изд-во", 100);
+        if (!addAfter(L, titles[i], b)) freeBook(L, b);
+    });
+    timed("remove", scans, [&](size_t i) { sink += removeByTitle(L, titles[keys - 1 - i]); });
+
+    std::remove(file.c_str());
+    std::remove((file + ".z").c_str());
+    run.peakRssMb = peakRssMb();
+    bench::DoNotOptimize(sink);   // результаты запросов не выбрасываются
+    return run;
 }
 
-// Слияние: добавляем в список только тех книг из файла, которых ещё нет
-void mergeFromFile(BookList& L, const std::string& filename) {
-    std::ifstream in(filename, std::ios::binary);
-    if (!in) {
-        std::cerr << "Не удалось открыть файл для чтения\n";
-        return;
+std::string jsonString(std::string_view s) {
+    std::string r = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') r += '\\';
+        if ((unsigned char)c < 0x20) {
+            char tmp[8];
+            std::snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+            r += tmp;
+            continue;
+        }
+        r += c;
     }
-    size_t n; in.read(reinterpret_cast<char*>(&n), sizeof(n));
-    size_t added = 0;
-    for (size_t i = 0; i < n; ++i) {
-        auto rds = [&](void)->std::string {
-            uint32_t len;
-            in.read(reinterpret_cast<char*>(&len), sizeof(len));
-            std::string s(len, '\0');
-            in.read(&s[0], len);
-            return s;
-        };
-        std::string t = rds();
-        std::string a = rds();
-        int y; in.read(reinterpret_cast<char*>(&y), sizeof(y));
-        std::string p = rds();
-        int pg; in.read(reinterpret_cast<char*>(&pg), sizeof(pg));
-        BookNode temp(t,a,y,p,pg);
+    return r + "\"";
+}
 
-        bool exists = false;
-        for (BookNode* cur = L.head; cur; cur = cur->next) {
-            if (equals(cur, &temp)) {
-                exists = true;
-                break;
-            }
+void writeSuiteJson(std::ostream& out, uint32_t seed, const std::vector<SuiteRun>& runs) {
+    out << "{\n  \"seed\": " << seed << ",\n  \"runs\": [";
+    for (size_t r = 0; r < runs.size(); ++r) {
+        const SuiteRun& run = runs[r];
+        out << (r ? "," : "") << "\n    {\"n\": " << run.n << ", \"file_bytes\": " << run.fileBytes
+            << ", \"peak_rss_mb\": " << run.peakRssMb << ", \"ops\": [";
+        for (size_t i = 0; i < run.ops.size(); ++i) {
+            const OpTiming& op = run.ops[i];
+            out << (i ? "," : "") << "\n      {\"op\": " << jsonString(op.op);
+            if (!op.skipped.empty())
+                out << ", \"skipped\": " << jsonString(op.skipped) << "}";
+            else
+                out << ", \"reps\": " << op.reps << ", \"total_ms\": " << op.seconds * 1e3
+                    << ", \"ns_per_op\": " << op.seconds * 1e9 / op.reps << "}";
         }
-        if (!exists) {
-            addBack(L, new BookNode(t,a,y,p,pg));
-            ++added;
+        out << "\n    ]}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// Полный прогон на 10^3, 10^4, … до maxN книг; результаты — в bench_suite.json
+void benchSuite(size_t maxN) {
+    const uint32_t seed = 42;
+    const std::string json = "bench_suite.json";
+    std::vector<SuiteRun> runs;
+    for (size_t n = 1000; n <= maxN; n *= 10) {
+        runs.push_back(benchAllOps(n, seed));
+        std::cout << "Прогон на " << n << " книгах:\n";
+        for (const OpTiming& op : runs.back().ops) {
+            std::cout << "  " << op.op << ": ";
+            if (!op.skipped.empty()) std::cout << "пропущено (" << op.skipped << ")\n";
+            else std::cout << op.seconds * 1e9 / op.reps << " нс/оп × " << op.reps << "\n";
         }
+        std::ofstream out(json);   // переписываем после каждого размера
+        writeSuiteJson(out, seed, runs);
     }
-    std::cout << "Добавлено новых книг: " << added << "\n";
+    std::cout << "Результаты записаны в «" << json << "»\n";
 }
 
-// ==== Сортировка «пузырьком» по полям ====
+// only — имя одного замера (title, year, cache, shared, load, blocks, async, csv, packed, suite);
+// пусто — все, кроме suite
+int runBenchmarks(size_t n, const std::string& only) {
+    auto want = [&](const char* name) { return only.empty() || only == name; };
+    if (want("title"))  benchTitleIndex(n);
+    if (want("year"))   benchYearIndex(n);
+    if (want("cache"))  benchQueryCache(n);
+    if (want("shared")) benchSharedCatalog(std::min<size_t>(n, 10000));
+    if (want("load"))   benchLoadTeardown(n);
+    if (want("blocks")) benchBlockFile(n);
+    if (want("async"))  benchAsyncSave(n);
+    if (want("csv"))    benchCsv(n);
+    if (want("packed")) benchPackedFile(n);
+    if (only == "suite") benchSuite(n);
+    return 0;
+}
 
-void swapData(BookNode* A, BookNode* B) {
-    std::swap(A->title,     B->title);
-    std::swap(A->author,    B->author);
-    std::swap(A->year,      B->year);
-    std::swap(A->publisher, B->publisher);
-    std::swap(A->pages,     B->pages);
+// Печать результатов поиска
+void printFound(const std::vector<BookNode*>& found) {
+    if (found.empty()) {
+        std::cout << "Не найдено.\n";
+        return;
+    }
+    for (BookNode* n : found)
+        std::cout << "  «" << n->title << "», " << n->author << ", " << n->year << "\n";
 }
 
-// key = 't' (title), 'a' (author), 'y' (year)
-void sortList(BookList& L, char key) {
-    if (!L.head || !L.head->next) return;
-    bool swapped;
-    do {
-        swapped = false;
-        BookNode* cur = L.head;
-        while (cur->next) {
-            bool need = false;
-            if (key=='t' && cur->title > cur->next->title)        need = true;
-            if (key=='a' && cur->author > cur->next->author)      need = true;
-            if (key=='y' && cur->year > cur->next->year)          need = true;
-            if (need) {
-                swapData(cur, cur->next);
-                swapped = true;
-            }
-            cur = cur->next;
-        }
-    } while (swapped);
+// ==== Замеры для dcp/main.cpp (сборка с -DDCP_BENCH) ====
+
+#ifdef DCP_BENCH
+
+// Общий синтетический каталог на 10^5 книг для замеров поиска
+static BookList& benchCatalog() {
+    static BookList L;
+    if (!L.head) makeSyntheticBooks(L, 100000, 42);
+    return L;
+}
+
+BENCH_CASE("catalog/find_title", [](bench::State& st) {
+    BookList& L = benchCatalog();
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < 1024; ++i) keys.push_back(L.byId[i * 97 % L.byId.size()]->title.str());
+    findByTitle(L, keys[0]);   // индекс строится вне замера
+    while (st.next())
+        for (const std::string& k : keys) bench::DoNotOptimize(findByTitle(L, k));
+    st.setItems(1024);
+});
+
+BENCH_CASE("catalog/search_title", [](bench::State& st) {
+    BookList& L = benchCatalog();
+    // первые 5 байт заголовка, но без разрезанного символа UTF-8
+    std::string fragment = std::string(L.byId[7]->title);
+    size_t cut = std::min<size_t>(5, fragment.size());
+    while (cut > 0 && cut < fragment.size() && (uint8_t(fragment[cut]) & 0xC0) == 0x80) --cut;
+    fragment.resize(cut);
+    searchTitle(L, fragment, 10);
+    while (st.next()) bench::DoNotOptimize(searchTitle(L, fragment, 10));
+    st.setItems(1);
+});
+
+BENCH_CASE("catalog/year_stats", [](bench::State& st) {
+    BookList& L = benchCatalog();
+    yearRangeStats(L, 1950, 2000);
+    while (st.next()) bench::DoNotOptimize(yearRangeStats(L, 1950, 2000));
+    st.setItems(1);
+});
+
+// 64 авторов подряд: проход по списку и повтор из кэша запросов
+static std::vector<std::string> benchAuthors(const BookList& L) {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < 64; ++i) keys.push_back(L.byId[i * 7919 % L.byId.size()]->author.str());
+    return keys;
 }
 
+BENCH_CASE("catalog/author_scan", [](bench::State& st) {
+    BookList& L = benchCatalog();
+    const std::vector<std::string> keys = benchAuthors(L);
+    size_t found = 0;
+    while (st.next())
+        for (const std::string& k : keys) forEachByAuthor(L, k, [&](const BookNode&) { ++found; });
+    bench::DoNotOptimize(found);
+    st.setItems(64);
+});
+
+BENCH_CASE("catalog/author_cached", [](bench::State& st) {
+    BookList& L = benchCatalog();
+    const std::vector<std::string> keys = benchAuthors(L);
+    for (const std::string& k : keys) booksByAuthor(L, k);
+    while (st.next())
+        for (const std::string& k : keys) bench::DoNotOptimize(booksByAuthor(L, k));
+    st.setItems(64);
+});
+
+BENCH_CASE("catalog/sort_1000", [](bench::State& st) {
+    BookList L;
+    while (st.next()) {
+        st.pause();
+        clearList(L);
+        makeSyntheticBooks(L, 1000, 7);
+        st.resume();
+        sortList(L, 't');
+    }
+    st.setItems(1000);
+});
+
+BENCH_CASE("catalog/save_load_1e5", [](bench::State& st) {
+    BookList& src = benchCatalog();
+    const std::string file = "bench_catalog.bin";
+    BookList L;
+    const std::vector<const BookNode*> nodes = listNodes(src);
+    while (st.next()) {
+        writeBookFile(nodes, file, 0);
+        clearList(L);
+        std::ifstream in(file, std::ios::binary);
+        readBookFile(L, in, file, 0);
+    }
+    st.setBytes(double(fileBytes(file)));
+    std::remove(file.c_str());
+});
+#else
+
 // ==== Меню и main ====
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench")
+        return runBenchmarks(argc > 2 ? std::stoul(argv[2]) : 1000000,
+                             argc > 3 ? argv[3] : "");
+    if (argc > 1 && std::string(argv[1]) == "--stress") {
+        BookList L;
+        return stressSharedCatalog(L, argc > 2 ? std::stoi(argv[2]) : 8,
+                                   argc > 3 ? std::stod(argv[3]) : 5.0) ? 1 : 0;
+    }
+
     BookList library;
     const std::string filename = "books.bin";
 
     while (true) {
-        std::cout << "\n=== Меню ===\n"
+        finishAsyncSave(library, false);
+        std::cout << "\n=== Меню ===\n";
+        if (library.saving)
+            std::cout << "(идёт сохранение: " << int(asyncSaveProgress(library) * 100) << "%)\n";
+        std::cout
                   << "1) Добавить книгу в начало\n"
                   << "2) Добавить книгу в конец\n"
                   << "3) Добавить после заголовка\n"
@@ -294,12 +3065,22 @@ int main() {
                   << "6) Поиск по автору\n"
                   << "7) Поиск по году\n"
                   << "8) Показать все книги\n"
-                  << "9) Сохранить в файл\n"
+                  << "9) Сохранить в файл (в фоне)\n"
                   << "10) Загрузить из файла\n"
                   << "11) Добавить новые из файла\n"
                   << "12) Сортировать по названию\n"
                   << "13) Сортировать по автору\n"
                   << "14) Сортировать по году\n"
+                  << "15) Поиск по фрагменту заголовка\n"
+                  << "16) Поиск по началу заголовка\n"
+                  << "17) Книги за диапазон лет\n"
+                  << "18) Статистика за диапазон лет\n"
+                  << "19) Импорт из CSV/TSV\n"
+                  << "20) Экспорт в CSV/TSV\n"
+                  << "21) Сохранить в файл со сжатием (в фоне)\n"
+                  << "22) Добавить синтетические книги\n"
+                  << "23) Статистика кэша запросов\n"
+                  << "24) Проверка каталога в несколько потоков\n"
                   << "0) Выход\n"
                   << "Выберите пункт: ";
         int choice;
@@ -309,6 +3090,7 @@ int main() {
         std::string t, a, pub, key;
         int y, pg;
         bool ok;
+        BookNode* node;
 
         switch (choice) {
           case 0:
@@ -320,8 +3102,8 @@ int main() {
             y  = readInt("Год: ");
             std::cout << "Издательство: ";    std::getline(std::cin, pub);
             pg = readInt("Страниц: ");
-            if (choice==1) addFront(library, new BookNode(t,a,y,pub,pg));
-            else           addBack (library, new BookNode(t,a,y,pub,pg));
+            if (choice==1) addFront(library, newBook(library, t,a,y,pub,pg));
+            else           addBack (library, newBook(library, t,a,y,pub,pg));
             break;
           case 3:
             std::cout << "После какого заголовка? "; std::getline(std::cin, key);
@@ -330,8 +3112,12 @@ int main() {
             y  = readInt("Год: ");
             std::cout << "Издательство: ";            std::getline(std::cin, pub);
             pg = readInt("Страниц: ");
-            ok = addAfter(library, key, new BookNode(t,a,y,pub,pg));
-            if (!ok) std::cout << "Книга «" << key << "» не найдена.\n";
+            node = newBook(library, t,a,y,pub,pg);
+            ok = addAfter(library, key, node);
+            if (!ok) {
+                freeBook(library, node);
+                std::cout << "Книга «" << key << "» не найдена.\n";
+            }
             break;
           case 4:
             std::cout << "Какой заголовок удалить? "; std::getline(std::cin, key);
@@ -359,12 +3145,19 @@ int main() {
             printList(library);
             break;
           case 9:
-            saveToFile(library, filename);
+          case 21:
+            if (startAsyncSave(library, filename,
+                               choice == 21 ? BookFormat::PackedLz : BookFormat::Plain))
+                std::cout << "Сохранение начато, можно продолжать работу.\n";
+            else
+                std::cout << "Предыдущее сохранение ещё идёт.\n";
             break;
           case 10:
+            finishAsyncSave(library, true);   // читаем то, что только что сохранили
             loadFromFile(library, filename);
             break;
           case 11:
+            finishAsyncSave(library, true);
             mergeFromFile(library, filename);
             break;
           case 12:
@@ -379,15 +3172,83 @@ int main() {
             sortList(library, 'y');
             std::cout << "Отсортировано по году издания.\n";
             break;
+          case 15:
+            std::cout << "Фрагмент заголовка: "; std::getline(std::cin, key);
+            printFound(searchTitle(library, key, 10));
+            break;
+          case 16:
+            std::cout << "Начало заголовка: "; std::getline(std::cin, key);
+            printFound(findByTitlePrefix(library, key, 10));
+            break;
+          case 17:
+          case 18: {
+            int lo = readInt("С года: ");
+            int hi = readInt("По год: ");
+            if (choice == 17) {
+                size_t shown = 0;
+                findByYearRange(library, lo, hi, [&](const BookNode& b) {
+                    std::cout << "  " << b.year << ": «" << b.title << "», " << b.author << "\n";
+                    ++shown;
+                });
+                if (!shown) std::cout << "Не найдено.\n";
+                break;
+            }
+            YearStats st = yearRangeStats(library, lo, hi);
+            std::cout << "Книг: " << st.count << ", страниц: " << st.pages
+                      << ", в среднем: " << st.avgPages() << "\n";
+            auto authors = authorCountsInRange(library, lo, hi, 10);
+            for (size_t i = 0; i < authors.size(); ++i)
+                std::cout << "  " << authors[i].first << ": " << authors[i].second << "\n";
+            break;
+          }
+          case 19:
+          case 20: {
+            std::cout << "Имя файла (.csv или .tsv): "; std::getline(std::cin, key);
+            CsvStats st;
+            auto t0 = std::chrono::steady_clock::now();
+            ok = choice == 19 ? importCsv(library, key, csvDelimiter(key), st)
+                              : exportCsv(library, key, csvDelimiter(key), st);
+            double sec = secondsSince(t0);
+            if (!ok) {
+                std::cerr << "Не удалось открыть файл «" << key << "»\n";
+                break;
+            }
+            std::cout << (choice == 19 ? "Импортировано" : "Выгружено") << " книг: " << st.rows
+                      << " за " << sec * 1e3 << " мс (" << size_t(st.rows / std::max(sec, 1e-9))
+                      << " строк/с)\n";
+            if (st.bad)
+                std::cout << "Пропущено испорченных строк: " << st.bad
+                          << " (первая — " << st.firstBad << ")\n";
+            break;
+          }
+          case 22: {
+            int n = readInt("Сколько книг: ");
+            int seed = readInt("Зерно генератора: ");
+            makeSyntheticBooks(library, size_t(std::max(n, 0)), uint32_t(seed));
+            std::cout << "Всего книг: " << library.count << "\n";
+            break;
+          }
+          case 23: {
+            const QueryCache& C = library.queries;
+            std::cout << "Запросов в кэше: " << C.lru.size() << " (" << C.bytes / 1024 << " КБ из "
+                      << C.limit / 1024 << ")\n"
+                      << "Попаданий: " << C.hits << ", промахов: " << C.misses
+                      << ", вытеснено: " << C.evictions << ", сбросов из-за изменений: "
+                      << C.invalidations << "\n";
+            break;
+          }
+          case 24:
+            finishAsyncSave(library, true);   // каталог на время проверки переходит в SharedCatalog
+            y = readInt("Потоков-читателей: ");
+            stressSharedCatalog(library, std::clamp(y, 1, 256), 2.0);
+            break;
           default:
             std::cout << "Неверный пункт меню.\n";
         }
     }
 EXIT:
-    while (library.head) {
-        BookNode* tmp = library.head;
-        library.head = library.head->next;
-        delete tmp;
-    }
+    finishAsyncSave(library, true);
+    clearList(library);
     return 0;
 }
+#endif
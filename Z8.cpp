@@ -9,6 +9,25 @@
 
 #include <iostream>
 #include <vector>
+#include <string>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <random>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <charconv>
+#include <cstring>
+#include <set>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 using namespace std;
 
 // Узел двоичного дерева
@@ -38,7 +57,1099 @@ void PrintTree(PNode q, int indent = 0) {
     PrintTree(q->Left,  indent + 5);
 }
 
-int main() {
+// ==== Пул узлов и обходы без рекурсии ====
+
+// Узлы нарезаются из блоков по kSlab штук и освобождаются все разом:
+// Release() отдаёт n / kSlab блоков, а не n отдельных delete.
+// Node тривиально разрушаем, поэтому деструкторы узлов не вызываются.
+class NodeArena {
+public:
+    NodeArena() = default;
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+    NodeArena(NodeArena&&) = default;
+    NodeArena& operator=(NodeArena&&) = default;
+
+    PNode New(int key) {
+        if (used == kSlab) {
+            slabs.emplace_back(static_cast<Node*>(::operator new(kSlab * sizeof(Node))));
+            used = 0;
+        }
+        return new (slabs.back().get() + used++) Node(key);
+    }
+
+    void Release() {
+        slabs.clear();
+        used = kSlab;
+    }
+
+    size_t Count() const { return slabs.empty() ? 0 : (slabs.size() - 1) * kSlab + used; }
+
+private:
+    struct SlabDelete {
+        void operator()(Node* p) const { ::operator delete(p); }
+    };
+    static const size_t kSlab = 1 << 16;
+
+    vector<unique_ptr<Node, SlabDelete>> slabs;
+    size_t used = kSlab;
+};
+
+// То же дерево, что MakeTree, но узлы из пула и с явным стеком вместо
+// рекурсии: правое поддерево кладётся в стек раньше левого, поэтому ключи
+// раздаются в том же прямом порядке (из data[from…from+n-1])
+PNode MakeTreeIterative(const vector<int>& data, int from, int n, NodeArena& arena) {
+    struct Task { PNode* slot; int n; };
+    PNode root = nullptr;
+    vector<Task> stack;
+    stack.push_back({&root, n});
+    while (!stack.empty()) {
+        Task t = stack.back();
+        stack.pop_back();
+        if (t.n == 0) continue;
+        PNode q = arena.New(data[from++]);
+        *t.slot = q;
+        int n1 = t.n / 2;
+        int n2 = t.n - n1 - 1;
+        stack.push_back({&q->Right, n2});
+        stack.push_back({&q->Left, n1});
+    }
+    return root;
+}
+
+// Удаление дерева из отдельных new без рекурсии
+void DeleteTree(PNode q) {
+    vector<PNode> stack;
+    if (q) stack.push_back(q);
+    while (!stack.empty()) {
+        q = stack.back();
+        stack.pop_back();
+        if (q->Left)  stack.push_back(q->Left);
+        if (q->Right) stack.push_back(q->Right);
+        delete q;
+    }
+}
+
+// Печать как у PrintTree, но строки (отступ + ключ) собираются в одном
+// буфере, который сбрасывается в поток кусками по kChunk байт и
+// переиспользуется между вызовами
+class TreeRenderer {
+public:
+    void Render(PNode root, ostream& out) {
+        buf.clear();
+        stack.clear();
+        PNode q = root;
+        int indent = 0;
+        while (q || !stack.empty()) {
+            for (; q; q = q->Right, indent += 5) stack.push_back({q, indent});
+            auto [node, at] = stack.back();
+            stack.pop_back();
+            buf.append(size_t(at), ' ');
+            char num[16];
+            buf.append(num, to_chars(num, num + sizeof num, node->Key).ptr);
+            buf += '\n';
+            if (buf.size() >= kChunk) {
+                out.write(buf.data(), streamsize(buf.size()));
+                buf.clear();
+            }
+            q = node->Left;
+            indent = at + 5;
+        }
+        out.write(buf.data(), streamsize(buf.size()));
+        buf.clear();
+    }
+
+private:
+    static const size_t kChunk = 1 << 16;
+
+    string buf;
+    vector<pair<PNode, int>> stack;
+};
+
+// ==== Параллельное построение ====
+
+// Пул потоков с кражей работы. У каждого потока своя очередь: свои задачи
+// он снимает с конца (последние порождённые, их данные ещё в кэше), а
+// простаивающий поток крадёт из начала чужой очереди — там самые крупные
+// поддеревья. Задач немного (поддеревья крупнее cutoff), поэтому очереди
+// под обычным мьютексом. Поток, вызвавший построение, — рабочий номер 0.
+class WorkStealingPool {
+public:
+    struct Task {
+        function<void()> run;
+        atomic<bool> done{false};
+    };
+
+    explicit WorkStealingPool(int threads) : queues(size_t(max(1, threads))) {
+        for (int i = 1; i < Threads(); ++i) workers.emplace_back([this, i] { WorkerLoop(i); });
+    }
+
+    ~WorkStealingPool() {
+        stop = true;
+        for (thread& w : workers) w.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int Threads() const { return int(queues.size()); }
+    static int WorkerId() { return workerId; }
+
+    void Spawn(Task& t) {
+        Queue& q = queues[size_t(workerId)];
+        lock_guard<mutex> lock(q.m);
+        q.tasks.push_back(&t);
+    }
+
+    // Ждёт задачу t, а пока она не готова — выполняет свои и чужие задачи
+    void Wait(Task& t) {
+        while (!t.done.load(memory_order_acquire))
+            if (!RunOne(workerId)) this_thread::yield();
+    }
+
+private:
+    struct Queue {
+        mutex m;
+        deque<Task*> tasks;
+    };
+
+    bool RunOne(int id) {
+        Task* t = Take(id, true);
+        for (int i = 1; !t && i < Threads(); ++i) t = Take((id + i) % Threads(), false);
+        if (!t) return false;
+        t->run();
+        t->done.store(true, memory_order_release);
+        return true;
+    }
+
+    Task* Take(int id, bool own) {
+        Queue& q = queues[size_t(id)];
+        lock_guard<mutex> lock(q.m);
+        if (q.tasks.empty()) return nullptr;
+        Task* t;
+        if (own) {
+            t = q.tasks.back();
+            q.tasks.pop_back();
+        } else {
+            t = q.tasks.front();
+            q.tasks.pop_front();
+        }
+        return t;
+    }
+
+    void WorkerLoop(int id) {
+        workerId = id;
+        int idle = 0;
+        while (!stop.load(memory_order_acquire)) {
+            if (RunOne(id))
+                idle = 0;
+            else if (++idle < 64)
+                this_thread::yield();
+            else
+                this_thread::sleep_for(chrono::microseconds(50));
+        }
+    }
+
+    static inline thread_local int workerId = 0;
+    vector<Queue> queues;
+    vector<thread> workers;
+    atomic<bool> stop{false};
+};
+
+// Узел берёт data[from], левое поддерево (n1 ключей с from + 1) уходит
+// отдельной задачей, правое (с from + 1 + n1) строится здесь же. Начало
+// своего отрезка каждое поддерево знает заранее, так что общий курсор
+// не нужен. Поддеревья не больше cutoff строятся последовательно в пул
+// узлов текущего потока.
+void MakeSubtreeParallel(WorkStealingPool& pool, vector<NodeArena>& arenas, const vector<int>& data,
+                         int from, int n, int cutoff, PNode* slot) {
+    NodeArena& arena = arenas[size_t(WorkStealingPool::WorkerId())];
+    if (n <= cutoff) {
+        *slot = MakeTreeIterative(data, from, n, arena);
+        return;
+    }
+    PNode q = arena.New(data[from]);
+    *slot = q;
+    int n1 = n / 2;
+    int n2 = n - n1 - 1;
+    WorkStealingPool::Task left;
+    left.run = [&pool, &arenas, &data, from, n1, cutoff, q] {
+        MakeSubtreeParallel(pool, arenas, data, from + 1, n1, cutoff, &q->Left);
+    };
+    pool.Spawn(left);
+    MakeSubtreeParallel(pool, arenas, data, from + 1 + n1, n2, cutoff, &q->Right);
+    pool.Wait(left);
+}
+
+// То же дерево, что MakeTree; узлы лежат в arenas (по одному пулу на поток)
+PNode MakeTreeParallel(const vector<int>& data, int n, WorkStealingPool& pool,
+                       vector<NodeArena>& arenas, int cutoff = 1 << 14) {
+    arenas.resize(size_t(pool.Threads()));
+    PNode root = nullptr;
+    MakeSubtreeParallel(pool, arenas, data, 0, n, max(cutoff, 1), &root);
+    return root;
+}
+
+// ==== Поиск по дереву ====
+
+// Дерево той же формы, что MakeTree, но ключи из отсортированного
+// sorted[from…from+n-1] раздаются в симметричном порядке (left, root, right),
+// так что получается дерево поиска
+PNode MakeSearchTree(const vector<int>& sorted, int& from, int n) {
+    if (n == 0) return nullptr;
+    int n1 = n / 2;
+    int n2 = n - n1 - 1;
+    PNode left = MakeSearchTree(sorted, from, n1);
+    PNode root = new Node(sorted[from++]);
+    root->Left  = left;
+    root->Right = MakeSearchTree(sorted, from, n2);
+    return root;
+}
+
+bool FindKey(PNode q, int x) {
+    while (q) {
+        if (x == q->Key) return true;
+        q = x < q->Key ? q->Left : q->Right;
+    }
+    return false;
+}
+
+inline void Prefetch(const void* p) {
+#if defined(__GNUC__)
+    __builtin_prefetch(p);
+#else
+    (void)p;
+#endif
+}
+
+// Номер младшего нулевого бита, считая с 1 (как ffs(~k))
+inline int LowestZeroBit(uint64_t k) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(~k) + 1;
+#else
+    int i = 1;
+    while (k & 1) { k >>= 1; ++i; }
+    return i;
+#endif
+}
+
+// Неявное дерево поиска в раскладке Эйтцингера: ключи лежат массивом в
+// порядке обхода в ширину, корень в t[1], дети узла k — в t[2k] и t[2k+1].
+// Указателей нет, верхние уровни сидят в кэше рядом друг с другом, а массив
+// выровнен по 64 байтам, поэтому t[16k…16k+15] — одна строка кэша с
+// потомками узла k на четыре уровня вниз, её и подгружаем заранее.
+struct EytzingerTree {
+    struct AlignedDelete {
+        void operator()(int* p) const { ::operator delete[](p, align_val_t(64)); }
+    };
+
+    int n = 0;
+    int levels = 0;                        // шагов спуска до листа
+    unique_ptr<int[], AlignedDelete> t;    // t[1…n], t[0] не используется
+};
+
+// Раскладывает отсортированный sorted в t начиная с узла k (симметричный обход)
+void FillEytzinger(EytzingerTree& e, const vector<int>& sorted, size_t& from, size_t k) {
+    if (k > size_t(e.n)) return;
+    FillEytzinger(e, sorted, from, 2 * k);
+    e.t[k] = sorted[from++];
+    FillEytzinger(e, sorted, from, 2 * k + 1);
+}
+
+// Строит неявное дерево прямо из входного массива (в любом порядке)
+EytzingerTree MakeEytzinger(const vector<int>& data) {
+    vector<int> sorted(data);
+    sort(sorted.begin(), sorted.end());
+    EytzingerTree e;
+    e.n = int(sorted.size());
+    while ((1LL << e.levels) <= e.n) ++e.levels;
+    e.t.reset(static_cast<int*>(::operator new[]((size_t(e.n) + 1) * sizeof(int), align_val_t(64))));
+    e.t[0] = 0;
+    size_t from = 0;
+    FillEytzinger(e, sorted, from, 1);
+    return e;
+}
+
+// Индекс в t наименьшего ключа >= x (0, если такого нет), без ветвлений:
+// путь спуска записывается битами k, а ffs(~k) отрезает хвост поворотов
+// направо после последнего поворота налево
+size_t EytzingerLowerBound(const EytzingerTree& e, int x) {
+    const int* t = e.t.get();
+    uint64_t k = 1;
+    while (k <= uint64_t(e.n)) {
+        Prefetch(t + 16 * k);
+        k = 2 * k + (t[k] < x);
+    }
+    return size_t(k >> LowestZeroBit(k));
+}
+
+bool FindEytzinger(const EytzingerTree& e, int x) {
+    size_t k = EytzingerLowerBound(e, x);
+    return k != 0 && e.t[k] == x;
+}
+
+// Поиск m ключей разом: группы по kGroup спускаются одновременно, так что
+// промахи кэша разных поисков перекрываются. Все ветви делают ровно
+// levels шагов: вышедший за n спуск дописывает единицы (поворот направо),
+// что не меняет ответ. found[i] = 1, если keys[i] есть в дереве.
+void FindManyEytzinger(const EytzingerTree& e, const int* keys, size_t m, uint8_t* found) {
+    const size_t kGroup = 16;
+    const int* t = e.t.get();
+    const uint64_t n = uint64_t(e.n);
+    uint64_t k[kGroup];
+    for (size_t base = 0; base < m; base += kGroup) {
+        size_t g = min(kGroup, m - base);
+        for (size_t j = 0; j < g; ++j) k[j] = 1;
+        for (int step = 0; step < e.levels; ++step) {
+            for (size_t j = 0; j < g; ++j) {
+                uint64_t kj = k[j];
+                Prefetch(t + 16 * (kj <= n ? kj : 0));
+                k[j] = 2 * kj + (kj > n || t[kj <= n ? kj : 0] < keys[base + j]);
+            }
+        }
+        for (size_t j = 0; j < g; ++j) {
+            size_t r = size_t(k[j] >> LowestZeroBit(k[j]));
+            found[base + j] = r != 0 && t[r] == keys[base + j];
+        }
+    }
+}
+
+// ==== B+-дерево ====
+
+// Ключи узла вместе со счётчиком и признаком листа занимают ровно одну
+// строку кэша, сравнение с искомым делается SIMD по четыре ключа.
+// Значения листа и указатели на потомков лежат в следующих строках и
+// читаются уже после выбора позиции. Все значения лежат в листьях,
+// листья связаны в список для обхода диапазонов.
+const int kBKeys = 15;
+const int kBMin = kBKeys / 2;          // меньше — узел занимает у соседа или сливается
+
+struct alignas(64) BNode {
+    int keys[kBKeys] = {};
+    int16_t count = 0;                 // на месте 16-го ключа; CompareMask его отбрасывает
+    bool leaf;
+    explicit BNode(bool isLeaf) : leaf(isLeaf) {}
+};
+static_assert(sizeof(BNode) == 64, "ключи узла — одна строка кэша");
+
+struct BLeaf : BNode {
+    int values[kBKeys];
+    BLeaf* next = nullptr;
+    BLeaf() : BNode(true) {}
+};
+
+struct BInner : BNode {
+    BNode* child[kBKeys + 1];          // в child[i] ключи из [keys[i-1], keys[i])
+    BInner() : BNode(false) {}
+};
+
+inline int PopCount(unsigned m) {
+#if defined(__GNUC__)
+    return __builtin_popcount(m);
+#else
+    int c = 0;
+    for (; m; m &= m - 1) ++c;
+    return c;
+#endif
+}
+
+// Маска сравнения ключей узла с x: бит i — keys[i] < x (less) или keys[i] > x
+inline unsigned CompareMask(const BNode* q, int x, bool less) {
+    unsigned m = 0;
+#if defined(__SSE2__)
+    __m128i v = _mm_set1_epi32(x);
+    const __m128i* k = reinterpret_cast<const __m128i*>(q->keys);
+    for (int i = 0; i < (kBKeys + 3) / 4; ++i) {   // последняя четвёрка захватывает count
+        __m128i a = _mm_load_si128(k + i);
+        __m128i c = less ? _mm_cmplt_epi32(a, v) : _mm_cmpgt_epi32(a, v);
+        m |= unsigned(_mm_movemask_ps(_mm_castsi128_ps(c))) << (4 * i);
+    }
+#else
+    for (int i = 0; i < kBKeys; ++i) m |= unsigned(less ? q->keys[i] < x : q->keys[i] > x) << i;
+#endif
+    return m & ((1u << q->count) - 1);
+}
+
+// Число ключей узла меньше x — позиция x в листе
+inline int CountLess(const BNode* q, int x) { return PopCount(CompareMask(q, x, true)); }
+
+// Число ключей узла не больше x — номер потомка, где искать x
+inline int CountNotGreater(const BNode* q, int x) { return q->count - PopCount(CompareMask(q, x, false)); }
+
+class BPlusTree {
+public:
+    BPlusTree() : root(new BLeaf) {}
+    ~BPlusTree() { FreeNodes(root); }
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+
+    size_t Size() const { return size; }
+    const BNode* Root() const { return root; }
+
+    void Clear() {
+        FreeNodes(root);
+        root = new BLeaf;
+        size = 0;
+    }
+
+    // Вставляет ключ или обновляет значение; true, если ключ новый
+    bool Insert(int key, int value = 0) {
+        int sep;
+        BNode* right = nullptr;
+        bool added = InsertInto(root, key, value, sep, right);
+        if (right) {
+            BInner* r = new BInner;
+            r->count = 1;
+            r->keys[0] = sep;
+            r->child[0] = root;
+            r->child[1] = right;
+            root = r;
+        }
+        size += added;
+        return added;
+    }
+
+    bool Erase(int key) {
+        if (!EraseFrom(root, key)) return false;
+        --size;
+        if (!root->leaf && root->count == 0) {
+            BInner* r = static_cast<BInner*>(root);
+            root = r->child[0];
+            delete r;
+        }
+        return true;
+    }
+
+    // Указатель на значение ключа или nullptr
+    const int* Find(int key) const {
+        const BLeaf* a = FindLeaf(key);
+        int pos = CountLess(a, key);
+        return pos < a->count && a->keys[pos] == key ? &a->values[pos] : nullptr;
+    }
+
+    bool Contains(int key) const { return Find(key) != nullptr; }
+
+    // Вызывает f(ключ, значение) для всех ключей из [lo, hi] по возрастанию
+    template <class F>
+    void Scan(int lo, int hi, F f) const {
+        const BLeaf* a = FindLeaf(lo);
+        for (int pos = CountLess(a, lo); a; a = a->next, pos = 0)
+            for (; pos < a->count; ++pos) {
+                if (a->keys[pos] > hi) return;
+                f(a->keys[pos], a->values[pos]);
+            }
+    }
+
+    // Строит дерево снизу вверх из отсортированных ключей (повторы
+    // пропускаются) за O(n); values, если задан, — значения тех же позиций
+    void BulkLoad(const vector<int>& sorted, const vector<int>* values = nullptr) {
+        FreeNodes(root);
+        size_t n = 0;
+        for (size_t i = 0; i < sorted.size(); ++i) n += i == 0 || sorted[i] != sorted[i - 1];
+        size = n;
+        if (n == 0) {
+            root = new BLeaf;
+            return;
+        }
+
+        // Ключи делятся между листьями поровну, так что в каждом не меньше kBMin
+        size_t leaves = (n + kBKeys - 1) / kBKeys;
+        vector<BNode*> level(leaves);
+        vector<int> mins(leaves);
+        BLeaf* prev = nullptr;
+        size_t src = 0;
+        for (size_t j = 0; j < leaves; ++j) {
+            BLeaf* a = new BLeaf;
+            a->count = int(n / leaves + (j < n % leaves));
+            for (int i = 0; i < a->count; ++src) {
+                if (src > 0 && sorted[src] == sorted[src - 1]) continue;
+                a->keys[i] = sorted[src];
+                a->values[i++] = values ? (*values)[src] : 0;
+            }
+            if (prev) prev->next = a;
+            prev = a;
+            level[j] = a;
+            mins[j] = a->keys[0];
+        }
+
+        // Уровни выше: так же поровну, не больше kBKeys + 1 потомков на узел
+        while (level.size() > 1) {
+            size_t m = (level.size() + kBKeys) / (kBKeys + 1);
+            vector<BNode*> up(m);
+            vector<int> upMins(m);
+            size_t from = 0;
+            for (size_t j = 0; j < m; ++j) {
+                BInner* p = new BInner;
+                int children = int(level.size() / m + (j < level.size() % m));
+                p->count = children - 1;
+                for (int i = 0; i < children; ++i) {
+                    p->child[i] = level[from + i];
+                    if (i > 0) p->keys[i - 1] = mins[from + i];
+                }
+                up[j] = p;
+                upMins[j] = mins[from];
+                from += children;
+            }
+            level.swap(up);
+            mins.swap(upMins);
+        }
+        root = level[0];
+    }
+
+private:
+    const BLeaf* FindLeaf(int key) const {
+        const BNode* q = root;
+        while (!q->leaf) q = static_cast<const BInner*>(q)->child[CountNotGreater(q, key)];
+        return static_cast<const BLeaf*>(q);
+    }
+
+    static void FreeNodes(BNode* q) {
+        vector<BNode*> stack{q};
+        while (!stack.empty()) {
+            q = stack.back();
+            stack.pop_back();
+            if (q->leaf) {
+                delete static_cast<BLeaf*>(q);
+                continue;
+            }
+            BInner* p = static_cast<BInner*>(q);
+            stack.insert(stack.end(), p->child, p->child + p->count + 1);
+            delete p;
+        }
+    }
+
+    // Вставка в поддерево q. Если q пришлось разделить, right — новый
+    // правый сосед, sep — наименьший ключ его поддерева.
+    static bool InsertInto(BNode* q, int key, int value, int& sep, BNode*& right) {
+        if (!q->leaf) {
+            BInner* p = static_cast<BInner*>(q);
+            int i = CountNotGreater(p, key);
+            int childSep;
+            BNode* childRight = nullptr;
+            bool added = InsertInto(p->child[i], key, value, childSep, childRight);
+            if (childRight) InsertChild(p, i, childSep, childRight, sep, right);
+            return added;
+        }
+
+        BLeaf* a = static_cast<BLeaf*>(q);
+        int pos = CountLess(a, key);
+        if (pos < a->count && a->keys[pos] == key) {
+            a->values[pos] = value;
+            return false;
+        }
+        if (a->count == kBKeys) {
+            BLeaf* b = new BLeaf;
+            b->count = kBKeys - kBMin;
+            copy(a->keys + kBMin, a->keys + kBKeys, b->keys);
+            copy(a->values + kBMin, a->values + kBKeys, b->values);
+            a->count = kBMin;
+            b->next = a->next;
+            a->next = b;
+            right = b;
+            if (pos > kBMin) {
+                a = b;
+                pos -= kBMin;
+            }
+        }
+        copy_backward(a->keys + pos, a->keys + a->count, a->keys + a->count + 1);
+        copy_backward(a->values + pos, a->values + a->count, a->values + a->count + 1);
+        a->keys[pos] = key;
+        a->values[pos] = value;
+        ++a->count;
+        if (right) sep = right->keys[0];
+        return true;
+    }
+
+    // Добавляет в p ключ k и справа от него потомка c после child[i];
+    // переполненный узел делится пополам, средний ключ уходит наверх в sep
+    static void InsertChild(BInner* p, int i, int k, BNode* c, int& sep, BNode*& right) {
+        if (p->count < kBKeys) {
+            copy_backward(p->keys + i, p->keys + p->count, p->keys + p->count + 1);
+            copy_backward(p->child + i + 1, p->child + p->count + 1, p->child + p->count + 2);
+            p->keys[i] = k;
+            p->child[i + 1] = c;
+            ++p->count;
+            return;
+        }
+        int keys[kBKeys + 1];
+        BNode* child[kBKeys + 2];
+        copy(p->keys, p->keys + i, keys);
+        keys[i] = k;
+        copy(p->keys + i, p->keys + kBKeys, keys + i + 1);
+        copy(p->child, p->child + i + 1, child);
+        child[i + 1] = c;
+        copy(p->child + i + 1, p->child + kBKeys + 1, child + i + 2);
+
+        BInner* b = new BInner;
+        p->count = kBMin;
+        copy(keys, keys + kBMin, p->keys);
+        copy(child, child + kBMin + 1, p->child);
+        sep = keys[kBMin];
+        b->count = kBKeys - kBMin;
+        copy(keys + kBMin + 1, keys + kBKeys + 1, b->keys);
+        copy(child + kBMin + 1, child + kBKeys + 2, b->child);
+        right = b;
+    }
+
+    static bool EraseFrom(BNode* q, int key) {
+        if (q->leaf) {
+            BLeaf* a = static_cast<BLeaf*>(q);
+            int pos = CountLess(a, key);
+            if (pos == a->count || a->keys[pos] != key) return false;
+            copy(a->keys + pos + 1, a->keys + a->count, a->keys + pos);
+            copy(a->values + pos + 1, a->values + a->count, a->values + pos);
+            --a->count;
+            return true;
+        }
+        BInner* p = static_cast<BInner*>(q);
+        int i = CountNotGreater(p, key);
+        if (!EraseFrom(p->child[i], key)) return false;
+        if (p->child[i]->count < kBMin) Rebalance(p, i);
+        return true;
+    }
+
+    // child[i] стал меньше kBMin: занимаем ключ у соседа, если у него
+    // есть лишний, иначе сливаем с соседом
+    static void Rebalance(BInner* p, int i) {
+        if (i > 0 && p->child[i - 1]->count > kBMin)
+            BorrowLeft(p, i);
+        else if (i < p->count && p->child[i + 1]->count > kBMin)
+            BorrowRight(p, i);
+        else
+            Merge(p, i > 0 ? i - 1 : i);
+    }
+
+    static void BorrowLeft(BInner* p, int i) {
+        BNode* l = p->child[i - 1];
+        BNode* c = p->child[i];
+        copy_backward(c->keys, c->keys + c->count, c->keys + c->count + 1);
+        if (c->leaf) {
+            BLeaf* lc = static_cast<BLeaf*>(c);
+            copy_backward(lc->values, lc->values + c->count, lc->values + c->count + 1);
+            c->keys[0] = l->keys[l->count - 1];
+            lc->values[0] = static_cast<BLeaf*>(l)->values[l->count - 1];
+            p->keys[i - 1] = c->keys[0];
+        } else {
+            BInner* ic = static_cast<BInner*>(c);
+            copy_backward(ic->child, ic->child + c->count + 1, ic->child + c->count + 2);
+            c->keys[0] = p->keys[i - 1];
+            ic->child[0] = static_cast<BInner*>(l)->child[l->count];
+            p->keys[i - 1] = l->keys[l->count - 1];
+        }
+        --l->count;
+        ++c->count;
+    }
+
+    static void BorrowRight(BInner* p, int i) {
+        BNode* c = p->child[i];
+        BNode* r = p->child[i + 1];
+        if (c->leaf) {
+            BLeaf* lr = static_cast<BLeaf*>(r);
+            c->keys[c->count] = r->keys[0];
+            static_cast<BLeaf*>(c)->values[c->count] = lr->values[0];
+            copy(lr->values + 1, lr->values + r->count, lr->values);
+            copy(r->keys + 1, r->keys + r->count, r->keys);
+            p->keys[i] = r->keys[0];
+        } else {
+            BInner* ir = static_cast<BInner*>(r);
+            c->keys[c->count] = p->keys[i];
+            static_cast<BInner*>(c)->child[c->count + 1] = ir->child[0];
+            p->keys[i] = r->keys[0];
+            copy(r->keys + 1, r->keys + r->count, r->keys);
+            copy(ir->child + 1, ir->child + r->count + 1, ir->child);
+        }
+        ++c->count;
+        --r->count;
+    }
+
+    // Сливает child[j + 1] в child[j] и убирает разделитель keys[j]
+    static void Merge(BInner* p, int j) {
+        BNode* a = p->child[j];
+        BNode* b = p->child[j + 1];
+        if (a->leaf) {
+            BLeaf* la = static_cast<BLeaf*>(a);
+            BLeaf* lb = static_cast<BLeaf*>(b);
+            copy(b->keys, b->keys + b->count, a->keys + a->count);
+            copy(lb->values, lb->values + b->count, la->values + a->count);
+            a->count += b->count;
+            la->next = lb->next;
+            delete lb;
+        } else {
+            BInner* ia = static_cast<BInner*>(a);
+            BInner* ib = static_cast<BInner*>(b);
+            a->keys[a->count] = p->keys[j];
+            copy(b->keys, b->keys + b->count, a->keys + a->count + 1);
+            copy(ib->child, ib->child + b->count + 1, ia->child + a->count + 1);
+            a->count += b->count + 1;
+            delete ib;
+        }
+        copy(p->keys + j + 1, p->keys + p->count, p->keys + j);
+        copy(p->child + j + 2, p->child + p->count + 1, p->child + j + 1);
+        --p->count;
+    }
+
+    BNode* root;
+    size_t size = 0;
+};
+
+// Вид как у PrintTree (right, root, left): потомки справа налево, между
+// ними — ключи-разделители; лист печатается одной строкой
+void PrintTree(const BNode* q, ostream& out, int indent = 0) {
+    if (q->leaf) {
+        out << string(indent, ' ') << '[';
+        for (int i = 0; i < q->count; ++i) out << (i ? " " : "") << q->keys[i];
+        out << "]\n";
+        return;
+    }
+    const BInner* p = static_cast<const BInner*>(q);
+    for (int i = p->count; i >= 0; --i) {
+        PrintTree(p->child[i], out, indent + 5);
+        if (i > 0) out << string(indent, ' ') << p->keys[i - 1] << "\n";
+    }
+}
+
+void PrintTree(const BPlusTree& t, ostream& out = cout) { PrintTree(t.Root(), out); }
+
+// ==== Замеры (запуск: Z8 --bench [максимум ключей], Z8 --build [узлов],
+//      Z8 --btree [максимум ключей], Z8 --parallel [узлов]) ====
+
+double SecondsSince(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+// Пропускная способность поиска: дерево на указателях против неявного
+// дерева (по одному ключу и пачкой) на 10^3 … maxN ключей
+int RunBenchmarks(size_t maxN) {
+    const size_t queries = 2000000;
+    mt19937 rng(42);
+    cout << "ключей      указатели   lower_bound  Эйтцингер  пачкой   (млн поисков/с)\n";
+    for (size_t n = 1000; n <= maxN; n *= 10) {
+        vector<int> data(n);
+        for (int& x : data) x = int(rng() >> 1);
+        vector<int> keys(queries);
+        for (size_t i = 0; i < queries; ++i)   // половина ключей есть в дереве
+            keys[i] = i % 2 ? data[rng() % n] : int(rng() >> 1);
+
+        vector<int> sorted(data);
+        sort(sorted.begin(), sorted.end());
+        int from = 0;
+        PNode tree = MakeSearchTree(sorted, from, int(n));
+        EytzingerTree e = MakeEytzinger(data);
+
+        size_t hits[4] = {0, 0, 0, 0};
+        double sec[4];
+        auto t0 = chrono::steady_clock::now();
+        for (int x : keys) hits[0] += FindKey(tree, x);
+        sec[0] = SecondsSince(t0);
+        t0 = chrono::steady_clock::now();
+        for (int x : keys) hits[1] += binary_search(sorted.begin(), sorted.end(), x);
+        sec[1] = SecondsSince(t0);
+        t0 = chrono::steady_clock::now();
+        for (int x : keys) hits[2] += FindEytzinger(e, x);
+        sec[2] = SecondsSince(t0);
+        vector<uint8_t> found(queries);
+        t0 = chrono::steady_clock::now();
+        FindManyEytzinger(e, keys.data(), queries, found.data());
+        sec[3] = SecondsSince(t0);
+        for (uint8_t f : found) hits[3] += f;
+
+        cout << n;
+        for (int i = 0; i < 4; ++i) cout << "\t" << queries / sec[i] / 1e6;
+        if (hits[1] != hits[0] || hits[2] != hits[0] || hits[3] != hits[0]) cout << "\tОШИБКА";
+        cout << "\n";
+        DeleteTree(tree);
+    }
+    return 0;
+}
+
+// Поток-приёмник для замеров печати: ничего не пишет, только считает
+// контрольную сумму (FNV-1a по 8 байт), чтобы сравнить вывод двух способов печати
+class HashBuf : public streambuf {
+public:
+    HashBuf() { setp(block, block + sizeof block); }
+    uint64_t Hash() { Consume(); return hash; }
+
+protected:
+    int overflow(int c) override {
+        Consume();
+        if (c != traits_type::eof()) { *pptr() = char(c); pbump(1); }
+        return 0;
+    }
+    int sync() override { Consume(); return 0; }
+
+private:
+    void Consume() {
+        char* p = pbase();
+        for (; pptr() - p >= 8; p += 8) {
+            uint64_t w;
+            memcpy(&w, p, 8);
+            hash = (hash ^ w) * 1099511628211ULL;
+        }
+        for (; p != pptr(); ++p) hash = (hash ^ uint8_t(*p)) * 1099511628211ULL;
+        setp(block, block + sizeof block);
+    }
+
+    char block[1 << 16];
+    uint64_t hash = 14695981039346656037ULL;
+};
+
+// Построение, печать и освобождение n узлов: рекурсия и new/delete
+// против пула, явных стеков и буферизованной печати
+int RunBuildBenchmark(int n) {
+    mt19937 rng(42);
+    vector<int> data(n);
+    for (int& x : data) x = int(rng() >> 1);
+
+    auto t0 = chrono::steady_clock::now();
+    int from = 0;
+    PNode tree = MakeTree(data, from, n);
+    double build = SecondsSince(t0);
+    HashBuf sink;
+    streambuf* saved = cout.rdbuf(&sink);
+    t0 = chrono::steady_clock::now();
+    PrintTree(tree);
+    cout.flush();
+    double print = SecondsSince(t0);
+    cout.rdbuf(saved);
+    t0 = chrono::steady_clock::now();
+    DeleteTree(tree);
+    double release = SecondsSince(t0);
+    uint64_t hash = sink.Hash();
+    cout << "узлов " << n << ", секунды:  построение  печать  освобождение\n";
+    cout << "рекурсия, new/delete\t" << build << "\t" << print << "\t" << release << "\n";
+
+    NodeArena arena;
+    TreeRenderer renderer;
+    t0 = chrono::steady_clock::now();
+    tree = MakeTreeIterative(data, 0, n, arena);
+    build = SecondsSince(t0);
+    HashBuf sink2;
+    ostream out(&sink2);
+    t0 = chrono::steady_clock::now();
+    renderer.Render(tree, out);
+    out.flush();
+    print = SecondsSince(t0);
+    t0 = chrono::steady_clock::now();
+    arena.Release();
+    release = SecondsSince(t0);
+    cout << "пул, стек, буфер\t" << build << "\t" << print << "\t" << release;
+    cout << (sink2.Hash() == hash ? "\n" : "\tОШИБКА: вывод различается\n");
+    return 0;
+}
+
+// B+-дерево против std::set на 10^3 … maxN случайных ключей: вставка,
+// поиск (половина ключей есть), полный обход и удаление всех ключей, в млн
+// операций/с; для B+-дерева ещё загрузка из отсортированного массива.
+// std::set тратит ~48 байт на ключ, поэтому выше kSetLimit не меряется.
+int RunBTreeBenchmark(size_t maxN) {
+    const size_t kSetLimit = 20000000;
+    const size_t queries = 2000000;
+    mt19937 rng(42);
+    cout << "ключей      структура  вставка  поиск  обход  удаление  загрузка  (млн/с)\n";
+    for (size_t n = 1000; n <= maxN; n *= 10) {
+        vector<int> data(n);
+        for (int& x : data) x = int(rng() >> 1);
+        vector<int> keys(queries);
+        for (size_t i = 0; i < queries; ++i)
+            keys[i] = i % 2 ? data[rng() % n] : int(rng() >> 1);
+
+        size_t hits[2] = {0, 0}, sizes[2] = {0, 0};
+        long long sums[2] = {0, 0};
+        double sec[5];
+
+        BPlusTree t;
+        auto t0 = chrono::steady_clock::now();
+        for (int x : data) t.Insert(x, x);
+        sec[0] = SecondsSince(t0);
+        sizes[0] = t.Size();
+        t0 = chrono::steady_clock::now();
+        for (int x : keys) hits[0] += t.Contains(x);
+        sec[1] = SecondsSince(t0);
+        t0 = chrono::steady_clock::now();
+        t.Scan(INT_MIN, INT_MAX, [&](int k, int) { sums[0] += k; });
+        sec[2] = SecondsSince(t0);
+        t0 = chrono::steady_clock::now();
+        for (int x : data) t.Erase(x);
+        sec[3] = SecondsSince(t0);
+        vector<int> sorted(data);
+        sort(sorted.begin(), sorted.end());
+        t0 = chrono::steady_clock::now();
+        t.BulkLoad(sorted);
+        sec[4] = SecondsSince(t0);
+        bool ok = t.Size() == sizes[0];
+        t.Clear();
+        sorted = vector<int>();
+
+        cout << n << "\tB+-дерево";
+        cout << "\t" << n / sec[0] / 1e6 << "\t" << queries / sec[1] / 1e6 << "\t" << sizes[0] / sec[2] / 1e6
+             << "\t" << n / sec[3] / 1e6 << "\t" << n / sec[4] / 1e6 << "\n";
+
+        if (n > kSetLimit) {
+            cout << n << "\tstd::set\t—\n";
+            continue;
+        }
+        set<int> s;
+        t0 = chrono::steady_clock::now();
+        for (int x : data) s.insert(x);
+        sec[0] = SecondsSince(t0);
+        sizes[1] = s.size();
+        t0 = chrono::steady_clock::now();
+        for (int x : keys) hits[1] += s.count(x);
+        sec[1] = SecondsSince(t0);
+        t0 = chrono::steady_clock::now();
+        for (int k : s) sums[1] += k;
+        sec[2] = SecondsSince(t0);
+        t0 = chrono::steady_clock::now();
+        for (int x : data) s.erase(x);
+        sec[3] = SecondsSince(t0);
+        ok = ok && hits[0] == hits[1] && sizes[0] == sizes[1] && sums[0] == sums[1] && s.empty();
+
+        cout << n << "\tstd::set";
+        cout << "\t" << n / sec[0] / 1e6 << "\t" << queries / sec[1] / 1e6 << "\t" << sizes[1] / sec[2] / 1e6
+             << "\t" << n / sec[3] / 1e6 << (ok ? "\n" : "\tОШИБКА\n");
+    }
+    return 0;
+}
+
+// Контрольная сумма формы дерева и ключей в прямом порядке
+uint64_t TreeHash(PNode root) {
+    uint64_t h = 14695981039346656037ULL;
+    vector<PNode> stack{root};
+    while (!stack.empty()) {
+        PNode q = stack.back();
+        stack.pop_back();
+        h = (h ^ (q ? uint64_t(uint32_t(q->Key)) + 1 : 0)) * 1099511628211ULL;
+        if (q) {
+            stack.push_back(q->Right);
+            stack.push_back(q->Left);
+        }
+    }
+    return h;
+}
+
+// Ускорение параллельного построения n узлов на 1 … 32 потоках
+// относительно последовательного MakeTreeIterative
+int RunParallelBenchmark(int n) {
+    mt19937 rng(42);
+    vector<int> data(n);
+    for (int& x : data) x = int(rng() >> 1);
+
+    // Первый прогон прогревает кучу (страницы уже отображены), иначе
+    // последовательное построение платит за это одно
+    NodeArena arena;
+    MakeTreeIterative(data, 0, n, arena);
+    arena.Release();
+    auto t0 = chrono::steady_clock::now();
+    PNode tree = MakeTreeIterative(data, 0, n, arena);
+    double serial = SecondsSince(t0);
+    uint64_t hash = TreeHash(tree);
+    arena.Release();
+    cout << "узлов " << n << ", ядер " << thread::hardware_concurrency()
+         << ", последовательно " << serial << " с\n";
+    cout << "потоков  секунды  ускорение\n";
+
+    for (int threads = 1; threads <= 32; threads *= 2) {
+        WorkStealingPool pool(threads);
+        vector<NodeArena> arenas;
+        t0 = chrono::steady_clock::now();
+        tree = MakeTreeParallel(data, n, pool, arenas);
+        double sec = SecondsSince(t0);
+        bool ok = TreeHash(tree) == hash;
+        for (NodeArena& a : arenas) a.Release();
+        cout << threads << "\t" << sec << "\t" << serial / sec << (ok ? "\n" : "\tОШИБКА: другое дерево\n");
+    }
+    return 0;
+}
+
+#ifdef DCP_BENCH
+#include "dcp/Bench.h"
+
+// ==== Замеры для dcp/main.cpp ====
+
+static vector<int> BenchKeys(size_t n, unsigned seed) {
+    mt19937 rng(seed);
+    vector<int> data(n);
+    for (int& x : data) x = int(rng() >> 1);
+    return data;
+}
+
+BENCH_CASE("tree/make_recursive_1e5", [](bench::State& st) {
+    vector<int> data = BenchKeys(100000, 1);
+    while (st.next()) {
+        int from = 0;
+        PNode tree = MakeTree(data, from, int(data.size()));
+        st.pause();
+        DeleteTree(tree);
+        st.resume();
+    }
+    st.setItems(100000);
+});
+
+BENCH_CASE("tree/make_arena_1e5", [](bench::State& st) {
+    vector<int> data = BenchKeys(100000, 1);
+    NodeArena arena;
+    while (st.next()) {
+        bench::DoNotOptimize(MakeTreeIterative(data, 0, int(data.size()), arena));
+        arena.Release();
+    }
+    st.setItems(100000);
+});
+
+BENCH_CASE("tree/find_pointer_1e6", [](bench::State& st) {
+    vector<int> sorted = BenchKeys(1000000, 1);
+    sort(sorted.begin(), sorted.end());
+    vector<int> keys = BenchKeys(1024, 2);
+    int from = 0;
+    PNode tree = MakeSearchTree(sorted, from, int(sorted.size()));
+    while (st.next())
+        for (int x : keys) bench::DoNotOptimize(FindKey(tree, x));
+    DeleteTree(tree);
+    st.setItems(1024);
+});
+
+BENCH_CASE("tree/find_eytzinger_1e6", [](bench::State& st) {
+    EytzingerTree e = MakeEytzinger(BenchKeys(1000000, 1));
+    vector<int> keys = BenchKeys(1024, 2);
+    while (st.next())
+        for (int x : keys) bench::DoNotOptimize(FindEytzinger(e, x));
+    st.setItems(1024);
+});
+
+BENCH_CASE("tree/find_btree_1e6", [](bench::State& st) {
+    vector<int> sorted = BenchKeys(1000000, 1);
+    sort(sorted.begin(), sorted.end());
+    BPlusTree t;
+    t.BulkLoad(sorted);
+    vector<int> keys = BenchKeys(1024, 2);
+    while (st.next())
+        for (int x : keys) bench::DoNotOptimize(t.Contains(x));
+    st.setItems(1024);
+});
+
+BENCH_CASE("tree/btree_insert_erase_1e6", [](bench::State& st) {
+    vector<int> sorted = BenchKeys(1000000, 1);
+    sort(sorted.begin(), sorted.end());
+    BPlusTree t;
+    t.BulkLoad(sorted);
+    vector<int> keys = BenchKeys(1024, 3);
+    while (st.next()) {
+        for (int x : keys) t.Insert(x);
+        for (int x : keys) t.Erase(x);
+    }
+    st.setItems(2048);
+});
+#else
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench")
+        return RunBenchmarks(argc > 2 ? stoull(argv[2]) : 10000000);
+    if (argc > 1 && string(argv[1]) == "--build")
+        return RunBuildBenchmark(argc > 2 ? stoi(argv[2]) : 10000000);
+    if (argc > 1 && string(argv[1]) == "--btree")
+        return RunBTreeBenchmark(argc > 2 ? stoull(argv[2]) : 10000000);
+    if (argc > 1 && string(argv[1]) == "--parallel")
+        return RunParallelBenchmark(argc > 2 ? stoi(argv[2]) : 100000000);
+
     int n;
     cout << "Сколько узлов добавить? ";
     if (!(cin >> n) || n < 0) {
@@ -55,15 +1166,15 @@ int main() {
         data.push_back(x);
     }
 
-    int pos = 0;
-    PNode tree = MakeTree(data, pos, n);
+    NodeArena arena;
+    PNode tree = MakeTreeIterative(data, 0, n, arena);
 
     cout << "\nДерево (reverse inorder — right, root, left):\n\n";
-    PrintTree(tree);
+    TreeRenderer().Render(tree, cout);
 
-    // Освобождаем память
-    // (простой способ — рекурсивно удалять узлы)
-    // здесь для краткости пропущен, но в реальном коде нужно пройтись по всем узлам и delete
+    // Все узлы лежат в пуле и освобождаются одним вызовом
+    arena.Release();
 
     return 0;
 }
+#endif
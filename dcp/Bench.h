@@ -0,0 +1,267 @@
+#pragma once
+
+// Микро-замеры с прогревом, подбором числа итераций и статистикой по
+// повторам. Случай регистрируется где угодно (в том числе в Z*.cpp при
+// сборке с -DDCP_BENCH), запускает всё dcp/main.cpp:
+//
+//     BENCH_CASE("bigint/mul", [](bench::State& st) {
+//         BigInt a = ..., b = ...;          // подготовка не замеряется
+//         while (st.next())
+//             bench::DoNotOptimize(a * b);
+//         st.setItems(1);                    // операций за итерацию
+//     });
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace bench {
+
+// Не даёт компилятору выбросить вычисление value
+template <class T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+    _ReadWriteBarrier();
+#endif
+}
+
+// Заставляет считать, что вся память прочитана и записана
+inline void ClobberMemory() {
+#if defined(__GNUC__)
+    asm volatile("" : : : "memory");
+#else
+    _ReadWriteBarrier();
+#endif
+}
+
+// Состояние одного прогона: случай крутит while (st.next()) ровно
+// iterations() раз; время идёт от первого next() до последнего,
+// кроме участков между pause() и resume()
+class State {
+    using Clock = std::chrono::steady_clock;
+
+    std::uint64_t iters;
+    std::uint64_t left;
+    Clock::time_point t0;
+    Clock::duration spent{};
+    bool running = false;
+    double items = 0, bytes = 0;
+
+public:
+    explicit State(std::uint64_t iterations) : iters(iterations), left(iterations) {}
+
+    bool next() {
+        if (left == iters && !running) resume();
+        if (left == 0) {
+            pause();
+            return false;
+        }
+        --left;
+        return true;
+    }
+
+    void pause() {
+        if (running) spent += Clock::now() - t0;
+        running = false;
+    }
+
+    void resume() {
+        running = true;
+        t0 = Clock::now();
+    }
+
+    std::uint64_t iterations() const { return iters; }
+    bool finished() const { return left == 0 && !running; }
+    double seconds() const { return std::chrono::duration<double>(spent).count(); }
+
+    // Пропускная способность: обработано элементов / байт за одну итерацию
+    void setItems(double perIteration) { items = perIteration; }
+    void setBytes(double perIteration) { bytes = perIteration; }
+    double itemsPerIteration() const { return items; }
+    double bytesPerIteration() const { return bytes; }
+};
+
+struct Case {
+    std::string name;
+    std::function<void(State&)> fn;
+};
+
+inline std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+struct Registrar {
+    Registrar(std::string name, std::function<void(State&)> fn) {
+        registry().push_back({std::move(name), std::move(fn)});
+    }
+};
+
+struct Options {
+    double warmup = 0.1;        // секунд прогрева до первого замера
+    double sampleTime = 0.02;   // секунд на один повтор
+    int samples = 20;
+    std::string filter;         // подстрока имени; пусто — все
+    int cpu = -1;               // привязать поток к ядру; -1 — нет
+};
+
+struct Result {
+    std::string name;
+    std::uint64_t iterations = 0;   // итераций в каждом повторе
+    std::vector<double> ns;         // нс на итерацию по повторам
+    double median = 0, mad = 0, ciLow = 0, ciHigh = 0, min = 0;
+    double items = 0, bytes = 0;    // за итерацию
+};
+
+inline bool pinToCpu(int cpu) {
+#if defined(_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof set, &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+inline double runOnce(const Case& c, std::uint64_t iters, State* out = nullptr) {
+    State st(iters);
+    c.fn(st);
+    if (!st.finished())
+        throw std::logic_error(c.name + ": цикл while (st.next()) не доведён до конца");
+    if (out) *out = st;
+    return st.seconds();
+}
+
+// Медиана, MAD и 95% доверительный интервал медианы по порядковым
+// статистикам (без предположений о распределении)
+inline void summarize(Result& r) {
+    std::vector<double> v = r.ns;
+    std::sort(v.begin(), v.end());
+    std::size_t n = v.size();
+    auto median = [](const std::vector<double>& s) {
+        std::size_t m = s.size() / 2;
+        return s.size() % 2 ? s[m] : (s[m - 1] + s[m]) / 2;
+    };
+    r.min = v.front();
+    r.median = median(v);
+    std::vector<double> dev(n);
+    for (std::size_t i = 0; i < n; ++i) dev[i] = std::fabs(v[i] - r.median);
+    std::sort(dev.begin(), dev.end());
+    r.mad = median(dev);
+    double half = 0.98 * std::sqrt(double(n));
+    long lo = long(std::floor(double(n) / 2 - half));
+    long hi = long(std::ceil(double(n) / 2 + half)) - 1;
+    r.ciLow = v[std::size_t(std::max(0L, lo))];
+    r.ciHigh = v[std::size_t(std::min(long(n) - 1, hi))];
+}
+
+// Прогрев и подбор числа итераций (повтор не короче sampleTime), затем
+// samples повторов с одним и тем же числом итераций
+inline Result run(const Case& c, const Options& o) {
+    Result r;
+    r.name = c.name;
+    std::uint64_t iters = 1;
+    auto start = std::chrono::steady_clock::now();
+    while (true) {
+        double sec = runOnce(c, iters);
+        double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (sec >= o.sampleTime && total >= o.warmup) break;
+        if (sec < o.sampleTime) {
+            double grow = sec > 0 ? 1.2 * o.sampleTime / sec : 100;
+            iters = std::uint64_t(double(iters) * std::min(100.0, std::max(2.0, grow)));
+        }
+    }
+    r.iterations = iters;
+    State last(0);
+    for (int i = 0; i < std::max(1, o.samples); ++i)
+        r.ns.push_back(runOnce(c, iters, &last) * 1e9 / double(iters));
+    r.items = last.itemsPerIteration();
+    r.bytes = last.bytesPerIteration();
+    summarize(r);
+    return r;
+}
+
+inline std::string formatTime(double ns) {
+    char buf[32];
+    if (ns < 1e3)
+        std::snprintf(buf, sizeof buf, "%.2f нс", ns);
+    else if (ns < 1e6)
+        std::snprintf(buf, sizeof buf, "%.2f мкс", ns / 1e3);
+    else if (ns < 1e9)
+        std::snprintf(buf, sizeof buf, "%.2f мс", ns / 1e6);
+    else
+        std::snprintf(buf, sizeof buf, "%.2f с", ns / 1e9);
+    return buf;
+}
+
+inline std::string formatRate(double perSecond, const char* unit) {
+    const char* prefix[] = {"", "K", "M", "G", "T"};
+    int k = 0;
+    for (; perSecond >= 1000 && k < 4; ++k) perSecond /= 1000;
+    char buf[48];
+    std::snprintf(buf, sizeof buf, "%.2f %s%s/с", perSecond, prefix[k], unit);
+    return buf;
+}
+
+inline void print(const Result& r, std::ostream& o = std::cout) {
+    char spread[32];
+    std::snprintf(spread, sizeof spread, "±%.1f%%", r.median > 0 ? 100 * r.mad / r.median : 0.0);
+    o << r.name << ": " << formatTime(r.median) << " " << spread
+      << "  [95%: " << formatTime(r.ciLow) << " … " << formatTime(r.ciHigh) << "]"
+      << "  мин " << formatTime(r.min)
+      << "  (" << r.ns.size() << " × " << r.iterations << " ит.)";
+    if (r.items > 0) o << "  " << formatRate(r.items * 1e9 / r.median, "оп");
+    if (r.bytes > 0) o << "  " << formatRate(r.bytes * 1e9 / r.median, "Б");
+    o << '\n';
+}
+
+// Запускает подходящие под фильтр случаи в порядке регистрации;
+// after, если задан, вызывается после печати результата каждого случая
+inline std::vector<Result> runAll(const Options& o, std::ostream& out = std::cout,
+                                  const std::function<void(const Case&, const Result&)>& after = nullptr) {
+    if (o.cpu >= 0 && !pinToCpu(o.cpu))
+        out << "Не удалось привязать поток к ядру " << o.cpu << ", замер без привязки\n";
+    std::vector<Result> results;
+    for (const Case& c : registry()) {
+        if (!o.filter.empty() && c.name.find(o.filter) == std::string::npos) continue;
+        results.push_back(run(c, o));
+        print(results.back(), out);
+        if (after) after(c, results.back());
+    }
+    return results;
+}
+
+} // namespace bench
+
+#define DCP_BENCH_CONCAT2(a, b) a##b
+#define DCP_BENCH_CONCAT(a, b) DCP_BENCH_CONCAT2(a, b)
+#define BENCH_CASE(name, fn) \
+    static bench::Registrar DCP_BENCH_CONCAT(benchCase_, __LINE__)(name, fn)
@@ -0,0 +1,562 @@
+// Перебор таблицы истинности булевой функции многих переменных
+// (то, что dcp/Z2.py делает вложенными циклами для f(x, y, z, w)).
+//
+// Выражение компилируется в линейную программу из побитовых операций над
+// 256-битными словами: в одном слове — 256 наборов значений переменных
+// (bit slicing). Младшие 8 переменных в слове заданы постоянными масками,
+// старшие одинаковы во всём слове и берутся из номера слова. Программа
+// выполняется сразу над пачкой из kBatch слов, чтобы разбор команды
+// окупался; пространство 2^n делится на куски между потоками.
+//
+// Сборка: g++ -std=c++17 -O2 -march=native -pthread dcp/BoolEval.cpp -o dcp/booleval
+// (без AVX2 слово — четыре uint64_t, компилятор сводит их к SSE2).
+//
+//     booleval [--vars x,y,z,w] [--threads N] [--list N|all] [--bitmap файл] "выражение"
+//     booleval --random n clauses [seed] ...   — случайная 3-КНФ для замеров
+//     booleval                                 — пример из Z2.py
+//
+// Синтаксис (от слабого к сильному): a -> b; or | ||; xor ^; and & &&;
+// not a; == !=; !a ~a; скобки, 0 1 True False, имена переменных.
+// Набор с номером i: первая переменная — старший бит i, как у вложенных циклов.
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// ==== 256-битное слово ====
+
+#if defined(__AVX2__)
+struct Vec {
+    __m256i v;
+    static Vec ones() { return {_mm256_set1_epi64x(-1)}; }
+    static Vec zeros() { return {_mm256_setzero_si256()}; }
+    static Vec lanes(std::uint64_t a, std::uint64_t b, std::uint64_t c, std::uint64_t d) {
+        return {_mm256_setr_epi64x(std::int64_t(a), std::int64_t(b), std::int64_t(c), std::int64_t(d))};
+    }
+    friend Vec operator&(Vec a, Vec b) { return {_mm256_and_si256(a.v, b.v)}; }
+    friend Vec operator|(Vec a, Vec b) { return {_mm256_or_si256(a.v, b.v)}; }
+    friend Vec operator^(Vec a, Vec b) { return {_mm256_xor_si256(a.v, b.v)}; }
+    friend Vec andNot(Vec a, Vec b) { return {_mm256_andnot_si256(a.v, b.v)}; }   // ~a & b
+};
+#else
+struct Vec {
+    std::uint64_t w[4];
+    static Vec ones() { return {{~0ULL, ~0ULL, ~0ULL, ~0ULL}}; }
+    static Vec zeros() { return {{0, 0, 0, 0}}; }
+    static Vec lanes(std::uint64_t a, std::uint64_t b, std::uint64_t c, std::uint64_t d) { return {{a, b, c, d}}; }
+    friend Vec operator&(Vec a, Vec b) { for (int i = 0; i < 4; ++i) a.w[i] &= b.w[i]; return a; }
+    friend Vec operator|(Vec a, Vec b) { for (int i = 0; i < 4; ++i) a.w[i] |= b.w[i]; return a; }
+    friend Vec operator^(Vec a, Vec b) { for (int i = 0; i < 4; ++i) a.w[i] ^= b.w[i]; return a; }
+    friend Vec andNot(Vec a, Vec b) { for (int i = 0; i < 4; ++i) a.w[i] = ~a.w[i] & b.w[i]; return a; }
+};
+#endif
+
+inline int popCount(std::uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    int c = 0;
+    for (; x; x &= x - 1) ++c;
+    return c;
+#endif
+}
+
+// Номер младшего единичного бита, x != 0
+inline int lowestBit(std::uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int i = 0;
+    for (; !(x & 1); x >>= 1) ++i;
+    return i;
+#endif
+}
+
+// ==== Разбор выражения ====
+
+enum class Op { Var, Const0, Const1, Not, And, Or, Xor, Eq, Implies };
+
+struct Expr {
+    Op op;
+    int var = -1;              // для Var
+    int a = -1, b = -1;        // операнды — номера узлов
+};
+
+class Parser {
+public:
+    Parser(const std::string& text, std::vector<std::string>& vars) : s(text), names(vars) {}
+
+    // Узлы в порядке создания (операнды раньше операции); корень — последний
+    std::vector<Expr> parse() {
+        int root = implies();
+        skipSpace();
+        if (pos != s.size()) fail("лишние символы");
+        if (root != int(nodes.size()) - 1) nodes.push_back(nodes[std::size_t(root)]);
+        return nodes;
+    }
+
+private:
+    const std::string& s;
+    std::vector<std::string>& names;
+    std::vector<Expr> nodes;
+    std::size_t pos = 0;
+
+    [[noreturn]] void fail(const std::string& what) {
+        throw std::runtime_error(what + " (позиция " + std::to_string(pos + 1) + ")");
+    }
+
+    void skipSpace() {
+        while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos]))) ++pos;
+    }
+
+    // Символьная лексема или слово целиком
+    bool accept(const char* tok) {
+        skipSpace();
+        std::size_t n = std::strlen(tok);
+        if (s.compare(pos, n, tok) != 0) return false;
+        bool word = std::isalpha(static_cast<unsigned char>(tok[0]));
+        if (word && pos + n < s.size()
+            && (std::isalnum(static_cast<unsigned char>(s[pos + n])) || s[pos + n] == '_'))
+            return false;
+        // «|» не должен съедать начало «||», «=» — «==» и т. п.
+        if (!word && n == 1 && pos + 1 < s.size() && s[pos + 1] == tok[0] && (tok[0] == '|' || tok[0] == '&'))
+            return false;
+        pos += n;
+        return true;
+    }
+
+    int add(Op op, int a = -1, int b = -1) {
+        nodes.push_back({op, -1, a, b});
+        return int(nodes.size()) - 1;
+    }
+
+    int implies() {
+        int a = orExpr();
+        if (accept("->")) return add(Op::Implies, a, implies());
+        return a;
+    }
+
+    int orExpr() {
+        int a = xorExpr();
+        while (accept("||") || accept("|") || accept("or")) a = add(Op::Or, a, xorExpr());
+        return a;
+    }
+
+    int xorExpr() {
+        int a = andExpr();
+        while (accept("^") || accept("xor")) a = add(Op::Xor, a, andExpr());
+        return a;
+    }
+
+    int andExpr() {
+        int a = notExpr();
+        while (accept("&&") || accept("&") || accept("and")) a = add(Op::And, a, notExpr());
+        return a;
+    }
+
+    int notExpr() {
+        if (accept("not")) return add(Op::Not, notExpr());
+        return cmpExpr();
+    }
+
+    int cmpExpr() {
+        int a = unary();
+        while (true) {
+            if (accept("==")) a = add(Op::Eq, a, unary());
+            else if (accept("!=")) a = add(Op::Xor, a, unary());
+            else return a;
+        }
+    }
+
+    int unary() {
+        if (accept("!") || accept("~")) return add(Op::Not, unary());
+        return atom();
+    }
+
+    int atom() {
+        skipSpace();
+        if (accept("(")) {
+            int a = implies();
+            if (!accept(")")) fail("ожидалась «)»");
+            return a;
+        }
+        if (accept("0") || accept("False")) return add(Op::Const0);
+        if (accept("1") || accept("True")) return add(Op::Const1);
+        std::size_t start = pos;
+        while (pos < s.size() && (std::isalnum(static_cast<unsigned char>(s[pos])) || s[pos] == '_')) ++pos;
+        if (start == pos || std::isdigit(static_cast<unsigned char>(s[start]))) fail("ожидалась переменная");
+        std::string name = s.substr(start, pos - start);
+        auto it = std::find(names.begin(), names.end(), name);
+        if (it == names.end()) {
+            names.push_back(name);
+            it = names.end() - 1;
+        }
+        nodes.push_back({Op::Var, int(it - names.begin()), -1, -1});
+        return int(nodes.size()) - 1;
+    }
+};
+
+// ==== Компиляция в линейную программу ====
+
+// Команда dst = a op b над регистрами; регистры переменных заполняются
+// до запуска программы, остальные переиспользуются по мере освобождения
+struct Instr {
+    Op op;
+    int dst, a, b;
+};
+
+struct Program {
+    int vars = 0;
+    int registers = 0;
+    std::vector<Instr> code;
+    int result = 0;            // регистр ответа
+    int constant = -1;         // 0/1, если функция — константа
+};
+
+Program compile(const std::vector<Expr>& nodes, int vars) {
+    // Свёртка констант и слияние одинаковых подвыражений
+    std::vector<int> canon(nodes.size());
+    std::vector<Expr> uniq;
+    std::map<std::tuple<int, int, int, int>, int> seen;
+    auto intern = [&](Expr e) {
+        if (e.op == Op::And || e.op == Op::Or || e.op == Op::Xor || e.op == Op::Eq)
+            if (e.a > e.b) std::swap(e.a, e.b);
+        auto key = std::make_tuple(int(e.op), e.var, e.a, e.b);
+        auto it = seen.find(key);
+        if (it != seen.end()) return it->second;
+        uniq.push_back(e);
+        return seen[key] = int(uniq.size()) - 1;
+    };
+    int c0 = intern({Op::Const0}), c1 = intern({Op::Const1});
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        Expr e = nodes[i];
+        if (e.a >= 0) e.a = canon[std::size_t(e.a)];
+        if (e.b >= 0) e.b = canon[std::size_t(e.b)];
+        bool ka = e.a == c0 || e.a == c1, kb = e.b == c0 || e.b == c1;
+        int va = e.a == c1, vb = e.b == c1;
+        int folded = -1;
+        switch (e.op) {
+        case Op::Not:
+            if (ka) folded = va ? c0 : c1;
+            else if (uniq[std::size_t(e.a)].op == Op::Not) folded = uniq[std::size_t(e.a)].a;
+            break;
+        case Op::And: if (ka) folded = va ? e.b : c0; else if (kb) folded = vb ? e.a : c0; break;
+        case Op::Or:  if (ka) folded = va ? c1 : e.b; else if (kb) folded = vb ? c1 : e.a; break;
+        case Op::Implies:
+            if (ka) folded = va ? e.b : c1;
+            else if (kb) folded = vb ? c1 : intern({Op::Not, -1, e.a});
+            break;
+        case Op::Xor:
+        case Op::Eq:
+            if (ka && kb) {
+                folded = (e.op == Op::Xor ? va != vb : va == vb) ? c1 : c0;
+            } else if (ka || kb) {
+                // x ^ 0 = x, x ^ 1 = !x; == наоборот
+                int x = ka ? e.b : e.a;
+                bool flip = (ka ? va : vb) == (e.op == Op::Xor);
+                folded = flip ? intern({Op::Not, -1, x}) : x;
+            }
+            break;
+        default: break;
+        }
+        canon[i] = folded >= 0 ? folded : intern(e);
+    }
+
+    Program p;
+    p.vars = vars;
+    int root = canon.back();
+    if (root == c0 || root == c1) {
+        p.constant = root == c1;
+        return p;
+    }
+
+    // Только узлы, нужные корню; время жизни — до последнего использования
+    std::vector<char> live(uniq.size(), 0);
+    live[std::size_t(root)] = 1;
+    for (int i = root; i >= 0; --i)
+        if (live[std::size_t(i)]) {
+            if (uniq[std::size_t(i)].a >= 0) live[std::size_t(uniq[std::size_t(i)].a)] = 1;
+            if (uniq[std::size_t(i)].b >= 0) live[std::size_t(uniq[std::size_t(i)].b)] = 1;
+        }
+    std::vector<int> lastUse(uniq.size(), -1);
+    for (int i = 0; i <= root; ++i)
+        if (live[std::size_t(i)])
+            for (int x : {uniq[std::size_t(i)].a, uniq[std::size_t(i)].b})
+                if (x >= 0) lastUse[std::size_t(x)] = i;
+
+    std::vector<int> reg(uniq.size(), -1);
+    std::vector<int> freeRegs;
+    p.registers = vars;
+    for (int i = 0; i <= root; ++i) {
+        if (!live[std::size_t(i)]) continue;
+        const Expr& e = uniq[std::size_t(i)];
+        if (e.op == Op::Var) {
+            reg[std::size_t(i)] = e.var;
+            continue;
+        }
+        // После свёртки константы операндами не бывают
+        int dst;
+        if (!freeRegs.empty()) {
+            dst = freeRegs.back();
+            freeRegs.pop_back();
+        } else {
+            dst = p.registers++;
+        }
+        reg[std::size_t(i)] = dst;
+        Instr in{e.op, dst, e.a >= 0 ? reg[std::size_t(e.a)] : -1, e.b >= 0 ? reg[std::size_t(e.b)] : -1};
+        p.code.push_back(in);
+        for (int x : {e.a, e.b == e.a ? -1 : e.b})
+            if (x >= 0 && lastUse[std::size_t(x)] == i && uniq[std::size_t(x)].op != Op::Var)
+                freeRegs.push_back(reg[std::size_t(x)]);
+    }
+    p.result = reg[std::size_t(root)];
+    return p;
+}
+
+// ==== Перебор ====
+
+const int kBatchLog = 6;
+const int kBatch = 1 << kBatchLog;                // слов на одну команду
+const std::uint64_t kBatchBits = 256 * kBatch;    // наборов в пачке
+const std::uint64_t kChunkBatches = 256;          // пачек в куске одного потока
+
+struct Options {
+    int threads = 0;
+    long long list = 0;        // сколько решений напечатать (-1 — все)
+    std::string bitmap;
+};
+
+struct Outcome {
+    std::uint64_t count = 0;
+    double seconds = 0;
+};
+
+// Значение переменной с номером бита bit (0 — младший) в слове w пачки
+Vec variableWord(int bit, std::uint64_t batch, int w) {
+    static const std::uint64_t low[6] = {
+        0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+        0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL};
+    if (bit < 6) return Vec::lanes(low[bit], low[bit], low[bit], low[bit]);
+    if (bit == 6) return Vec::lanes(0, ~0ULL, 0, ~0ULL);
+    if (bit == 7) return Vec::lanes(0, 0, ~0ULL, ~0ULL);
+    std::uint64_t word = batch * kBatch + std::uint64_t(w);
+    return (word >> (bit - 8)) & 1 ? Vec::ones() : Vec::zeros();
+}
+
+class Evaluator {
+public:
+    Evaluator(const Program& prog) : p(prog), regs(std::size_t(std::max(1, prog.registers)) * kBatch) {}
+
+    // Выполняет программу для пачки; значения переменных обновляются
+    // только у тех, что изменились с прошлой пачки
+    const Vec* run(std::uint64_t batch) {
+        for (int v = 0; v < p.vars; ++v) {
+            int bit = p.vars - 1 - v;
+            bool changes = bit >= 8 + kBatchLog && ((batch ^ last) >> (bit - 8 - kBatchLog)) != 0;
+            if (!filled || changes)
+                for (int w = 0; w < kBatch; ++w) at(v)[w] = variableWord(bit, batch, w);
+        }
+        filled = true;
+        last = batch;
+        for (const Instr& in : p.code) {
+            Vec* d = at(in.dst);
+            const Vec* a = in.a >= 0 ? at(in.a) : nullptr;
+            const Vec* b = in.b >= 0 ? at(in.b) : nullptr;
+            switch (in.op) {
+            case Op::Not:     for (int w = 0; w < kBatch; ++w) d[w] = a[w] ^ Vec::ones(); break;
+            case Op::And:     for (int w = 0; w < kBatch; ++w) d[w] = a[w] & b[w]; break;
+            case Op::Or:      for (int w = 0; w < kBatch; ++w) d[w] = a[w] | b[w]; break;
+            case Op::Xor:     for (int w = 0; w < kBatch; ++w) d[w] = a[w] ^ b[w]; break;
+            case Op::Eq:      for (int w = 0; w < kBatch; ++w) d[w] = a[w] ^ b[w] ^ Vec::ones(); break;
+            case Op::Implies: for (int w = 0; w < kBatch; ++w) d[w] = andNot(a[w], Vec::ones()) | b[w]; break;
+            default: break;
+            }
+        }
+        return at(p.result);
+    }
+
+private:
+    Vec* at(int r) { return &regs[std::size_t(r) * kBatch]; }
+
+    const Program& p;
+    std::vector<Vec> regs;
+    std::uint64_t last = 0;
+    bool filled = false;
+};
+
+void printAssignment(std::uint64_t i, int n) {
+    for (int v = 0; v < n; ++v) std::cout << ((i >> (n - 1 - v)) & 1) << ' ';
+    std::cout << "1\n";
+}
+
+Outcome enumerate(const Program& p, const std::vector<std::string>& names, const Options& o) {
+    const int n = p.vars;
+    const std::uint64_t total = 1ULL << n;
+    const std::uint64_t batches = (total + kBatchBits - 1) / kBatchBits;
+    const std::uint64_t chunks = (batches + kChunkBatches - 1) / kChunkBatches;
+    int threads = o.threads > 0 ? o.threads : int(std::max(1u, std::thread::hardware_concurrency()));
+    threads = int(std::min<std::uint64_t>(std::uint64_t(threads), chunks));
+
+    std::ofstream bitmap;
+    std::mutex bitmapLock;
+    if (!o.bitmap.empty()) {
+        bitmap.open(o.bitmap, std::ios::binary | std::ios::trunc);
+        if (!bitmap) throw std::runtime_error("не удалось открыть " + o.bitmap);
+    }
+    // Первые решения каждого куска; печатаются по порядку после перебора
+    std::vector<std::vector<std::uint64_t>> found(o.list ? chunks : 0);
+    std::atomic<std::uint64_t> nextChunk{0}, count{0};
+
+    auto worker = [&] {
+        Evaluator ev(p);
+        std::vector<std::uint64_t> words;
+        for (std::uint64_t c; (c = nextChunk++) < chunks;) {
+            std::uint64_t first = c * kChunkBatches, last = std::min(batches, first + kChunkBatches);
+            std::uint64_t local = 0;
+            words.clear();
+            std::uint64_t result[kBatch * 4];   // пачка как 64-битные слова, по порядку наборов
+            if (p.constant >= 0) std::fill(result, result + kBatch * 4, p.constant ? ~0ULL : 0);
+            for (std::uint64_t b = first; b < last; ++b) {
+                if (p.constant < 0) std::memcpy(result, ev.run(b), sizeof result);
+                std::uint64_t base = b * kBatchBits;
+                if (total - base >= kBatchBits && !o.list && !bitmap.is_open()) {
+                    for (std::uint64_t bits : result) local += std::uint64_t(popCount(bits));
+                    continue;
+                }
+                for (int k = 0; k < kBatch * 4 && base < total; ++k, base += 64) {
+                    std::uint64_t bits = result[k];
+                    if (total - base < 64) bits &= (1ULL << (total - base)) - 1;
+                    local += std::uint64_t(popCount(bits));
+                    if (bitmap.is_open()) words.push_back(bits);
+                    if (o.list) {
+                        auto& f = found[c];
+                        for (; bits && (o.list < 0 || (long long)f.size() < o.list); bits &= bits - 1)
+                            f.push_back(base + std::uint64_t(lowestBit(bits)));
+                    }
+                }
+            }
+            count += local;
+            if (bitmap.is_open()) {
+                std::uint64_t offset = first * kBatchBits / 8;
+                std::size_t bytes = std::size_t(std::min<std::uint64_t>(words.size() * 8, (total + 7) / 8 - offset));
+                std::lock_guard<std::mutex> lock(bitmapLock);
+                bitmap.seekp(std::streamoff(offset));
+                bitmap.write(reinterpret_cast<const char*>(words.data()), std::streamsize(bytes));
+            }
+        }
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+    Outcome out;
+    out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    out.count = count;
+
+    if (o.list) {
+        for (const std::string& name : names) std::cout << name << ' ';
+        std::cout << "f\n";
+        long long printed = 0;
+        for (const auto& f : found)
+            for (std::uint64_t i : f) {
+                if (o.list >= 0 && printed == o.list) break;
+                printAssignment(i, n);
+                ++printed;
+            }
+    }
+    return out;
+}
+
+// Случайная 3-КНФ: clauses дизъюнкций по три литерала из n переменных
+std::string randomCnf(int n, int clauses, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::ostringstream s;
+    for (int c = 0; c < clauses; ++c) {
+        s << (c ? " and (" : "(");
+        for (int k = 0; k < 3; ++k)
+            s << (k ? " or " : "") << (rng() % 2 ? "not " : "") << 'v' << rng() % unsigned(n);
+        s << ')';
+    }
+    return s.str();
+}
+
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    Options o;
+    std::vector<std::string> names;
+    std::string expr;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string a = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (a == "--vars" && hasValue) {
+                std::stringstream ss(argv[++i]);
+                for (std::string v; std::getline(ss, v, ',');) names.push_back(v);
+            } else if (a == "--threads" && hasValue) {
+                o.threads = std::stoi(argv[++i]);
+            } else if (a == "--list" && hasValue) {
+                std::string v = argv[++i];
+                o.list = v == "all" ? -1 : std::stoll(v);
+            } else if (a == "--bitmap" && hasValue) {
+                o.bitmap = argv[++i];
+            } else if (a == "--random" && i + 2 < argc) {
+                int n = std::stoi(argv[++i]), clauses = std::stoi(argv[++i]);
+                unsigned seed = i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))
+                    ? unsigned(std::stoul(argv[++i])) : 1u;
+                for (int v = 0; v < n; ++v) names.push_back("v" + std::to_string(v));
+                expr = randomCnf(n, clauses, seed);
+            } else if (expr.empty() && a.rfind("--", 0) != 0) {
+                expr = a;
+            } else {
+                std::cerr << "Неизвестный аргумент: " << a << '\n';
+                return 1;
+            }
+        }
+        if (expr.empty()) {   // пример из Z2.py
+            expr = "(w or not x) and (w == (not y)) and (not w or z)";
+            if (names.empty()) names = {"x", "y", "z", "w"};
+            if (!o.list) o.list = -1;
+        }
+
+        std::size_t declared = names.size();
+        std::vector<Expr> nodes = Parser(expr, names).parse();
+        if (declared && names.size() > declared)
+            throw std::runtime_error("переменная «" + names[declared] + "» не указана в --vars");
+        if (names.size() > 40) throw std::runtime_error("больше 40 переменных — 2^n не перебрать");
+        Program p = compile(nodes, int(names.size()));
+
+        Outcome r = enumerate(p, names, o);
+        double all = double(1ULL << names.size());
+        std::cout << "переменных " << names.size() << ", команд " << p.code.size()
+                  << ", выполнимых наборов " << r.count << " из " << (1ULL << names.size()) << '\n'
+                  << "время " << r.seconds << " с, " << all / r.seconds / 1e9 << " млрд наборов/с\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+// Счётчики производительности для участка кода. На Linux — perf_event_open:
+// аппаратные (такты, инструкции, промахи L1d/LLC, ошибки предсказания
+// ветвлений) одной группой, чтобы они включались и читались согласованно,
+// программные (отказы страниц, переключения контекста) — второй группой.
+// Счётчик, которого нет (виртуальная машина, perf_event_paranoid), просто
+// пропускается; если perf недоступен совсем — отказы страниц и
+// переключения берутся из getrusage.
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+class PerfCounters {
+public:
+    enum Event { Cycles, Instructions, L1Misses, LlcMisses, BranchMisses,
+                 PageFaults, ContextSwitches, kEvents };
+
+    struct Sample {
+        std::array<double, kEvents> value{};
+        std::array<bool, kEvents> valid{};
+    };
+
+    PerfCounters() {
+#if defined(__linux__)
+        const std::uint64_t l1 = PERF_COUNT_HW_CACHE_L1D
+            | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        open(hw, Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        open(hw, Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        open(hw, L1Misses, PERF_TYPE_HW_CACHE, l1);
+        open(hw, LlcMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        open(hw, BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        open(sw, PageFaults, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+        open(sw, ContextSwitches, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+#endif
+    }
+
+    ~PerfCounters() {
+#if defined(__linux__)
+        for (Group* g : {&hw, &sw})
+            for (auto& m : g->members) close(m.fd);
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool hardware() const { return !hw.members.empty(); }
+
+    // Откуда берутся значения — для подписи в отчёте
+    const char* source() const {
+        if (hardware()) return "perf";
+        if (!sw.members.empty()) return "perf, только программные";
+#if defined(__unix__) || defined(__APPLE__)
+        return "getrusage";
+#else
+        return "нет счётчиков";
+#endif
+    }
+
+    void start() {
+        rusageBefore = rusageNow();
+#if defined(__linux__)
+        for (Group* g : {&hw, &sw}) {
+            if (g->members.empty()) continue;
+            ioctl(g->members[0].fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(g->members[0].fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    // Разность с момента start(); при мультиплексировании значения
+    // масштабируются на долю времени, когда группа реально считала
+    Sample stop() {
+        Sample s;
+#if defined(__linux__)
+        for (Group* g : {&sw, &hw}) {
+            if (g->members.empty()) continue;
+            ioctl(g->members[0].fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            std::vector<std::uint64_t> buf(3 + g->members.size());
+            ssize_t want = ssize_t(buf.size() * sizeof(std::uint64_t));
+            if (read(g->members[0].fd, buf.data(), size_t(want)) != want || buf[2] == 0) continue;
+            double scale = double(buf[1]) / double(buf[2]);
+            for (std::size_t i = 0; i < g->members.size() && i < buf[0]; ++i) {
+                s.value[g->members[i].event] = double(buf[3 + i]) * scale;
+                s.valid[g->members[i].event] = true;
+            }
+        }
+#endif
+        std::array<double, 2> after = rusageNow();
+        if (!s.valid[PageFaults] && after[0] >= 0) {
+            s.value[PageFaults] = after[0] - rusageBefore[0];
+            s.valid[PageFaults] = true;
+        }
+        if (!s.valid[ContextSwitches] && after[1] >= 0) {
+            s.value[ContextSwitches] = after[1] - rusageBefore[1];
+            s.valid[ContextSwitches] = true;
+        }
+        return s;
+    }
+
+private:
+    struct Member {
+        Event event;
+        int fd;
+    };
+    struct Group {
+        std::vector<Member> members;   // members[0] — лидер группы
+    };
+
+#if defined(__linux__)
+    static void open(Group& g, Event e, std::uint32_t type, std::uint64_t config) {
+        perf_event_attr a;
+        std::memset(&a, 0, sizeof a);
+        a.size = sizeof a;
+        a.type = type;
+        a.config = config;
+        a.disabled = g.members.empty();
+        // Аппаратные — только пользовательский код; программные события
+        // (отказы, переключения) случаются в ядре, их считаем целиком,
+        // если это разрешено
+        a.exclude_kernel = type != PERF_TYPE_SOFTWARE;
+        a.exclude_hv = 1;
+        a.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        int leader = g.members.empty() ? -1 : g.members[0].fd;
+        int fd = int(syscall(SYS_perf_event_open, &a, 0, -1, leader, 0));
+        if (fd < 0 && !a.exclude_kernel) {
+            a.exclude_kernel = 1;
+            fd = int(syscall(SYS_perf_event_open, &a, 0, -1, leader, 0));
+        }
+        if (fd >= 0) g.members.push_back({e, fd});
+    }
+#endif
+
+    // {отказы страниц, переключения контекста} процесса или {-1, -1}
+    static std::array<double, 2> rusageNow() {
+#if defined(__unix__) || defined(__APPLE__)
+        rusage u;
+        if (getrusage(RUSAGE_SELF, &u) == 0)
+            return {double(u.ru_minflt + u.ru_majflt), double(u.ru_nvcsw + u.ru_nivcsw)};
+#endif
+        return {-1, -1};
+    }
+
+    Group hw, sw;
+    std::array<double, 2> rusageBefore{};
+};
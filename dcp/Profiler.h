@@ -0,0 +1,353 @@
+#pragma once
+
+// Иерархический профилировщик в стиле TimerGuard:
+//
+//     void f() {
+//         PROFILE_SCOPE("f");
+//         ...
+//     }
+//     Profiler::local().reserve(1 << 20);   // по желанию: буфер потока заранее
+//     ...
+//     Profiler::instance().report(std::cout);
+//     Profiler::instance().writeChromeTrace("trace.json");   // chrome://tracing, Perfetto
+//
+// На входе в область — только счётчик глубины и отметка времени, на
+// выходе — запись события в буфер своего потока (без блокировок).
+// Вложенность, self-время и статистика считаются при построении отчёта.
+// С -DDCP_PROFILE=0 макросы раскрываются в пустоту.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef DCP_PROFILE
+#define DCP_PROFILE 1
+#endif
+
+class Profiler {
+public:
+    struct Event {
+        const char* name;
+        std::uint64_t start;
+        std::uint64_t end;
+        std::uint32_t depth;
+    };
+
+    // Такты процессора там, где есть rdtsc; иначе наносекунды steady_clock
+    static std::uint64_t ticks() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    // Буфер событий одного потока. Пишет только сам поток; читатель видит
+    // count с release/acquire, а блоки никогда не перемещаются.
+    class ThreadBuffer {
+    public:
+        static constexpr std::size_t kChunk = 1 << 16;
+        static constexpr std::size_t kChunks = 4096;
+
+        explicit ThreadBuffer(std::uint32_t id) : tid(id) {}
+
+        void push(const Event& e) {
+            std::size_t n = count.load(std::memory_order_relaxed);
+            std::size_t c = n / kChunk;
+            if (c == kChunks) { ++dropped; return; }
+            Event* chunk = chunks[c].load(std::memory_order_relaxed);
+            if (!chunk) {
+                chunk = new Event[kChunk];
+                chunks[c].store(chunk, std::memory_order_release);
+            }
+            chunk[n % kChunk] = e;
+            count.store(n + 1, std::memory_order_release);
+        }
+
+        // Заранее выделяет и заполняет блоки под n событий, чтобы в
+        // замеряемом коде не было промахов страниц при первой записи
+        void reserve(std::size_t n) {
+            for (std::size_t c = 0; c < std::min(kChunks, (n + kChunk - 1) / kChunk); ++c)
+                if (!chunks[c].load(std::memory_order_relaxed)) {
+                    Event* chunk = new Event[kChunk]();
+                    chunks[c].store(chunk, std::memory_order_release);
+                }
+        }
+
+        std::vector<Event> snapshot() const {
+            std::size_t n = count.load(std::memory_order_acquire);
+            std::vector<Event> out;
+            out.reserve(n);
+            for (std::size_t i = 0; i < n; i += kChunk) {
+                const Event* chunk = chunks[i / kChunk].load(std::memory_order_acquire);
+                out.insert(out.end(), chunk, chunk + std::min(kChunk, n - i));
+            }
+            return out;
+        }
+
+        void clear() { count.store(0, std::memory_order_release); dropped = 0; }
+
+        ~ThreadBuffer() {
+            for (auto& c : chunks) delete[] c.load();
+        }
+
+        std::uint32_t tid;
+        std::uint32_t depth = 0;
+        std::size_t dropped = 0;
+
+    private:
+        std::atomic<std::size_t> count{0};
+        std::atomic<Event*> chunks[kChunks] = {};
+    };
+
+    static Profiler& instance() {
+        static Profiler p;
+        return p;
+    }
+
+    static ThreadBuffer& local() {
+        thread_local ThreadBuffer* buf = instance().registerThread();
+        return *buf;
+    }
+
+    // Сводная статистика области; path — цепочка имён от корня через " / "
+    struct Stats {
+        std::string path;
+        std::uint32_t depth = 0;
+        std::size_t calls = 0;
+        double total = 0, self = 0, min = 0, max = 0;   // нс
+        double p50 = 0, p90 = 0, p99 = 0;
+    };
+
+    // Собирает события всех потоков и сводит их по путям вызовов.
+    // Можно вызывать, пока другие потоки ещё пишут. Событие попадает в буфер
+    // при выходе из области, то есть раньше своего родителя; вложенные
+    // события ещё открытых областей пропускаются и войдут в отчёт, когда
+    // области закроются.
+    std::vector<Stats> collect() {
+        double nsPerTick = calibrate();
+        std::map<std::string, Acc> acc;
+        for (auto& buf : snapshotBuffers()) {
+            std::vector<Event> ev = buf.second;
+            std::sort(ev.begin(), ev.end(), [](const Event& a, const Event& b) {
+                return a.start != b.start ? a.start < b.start : a.depth < b.depth;
+            });
+            // Родитель события — ближайшее открытое событие на уровень выше,
+            // которое кончилось не раньше него; нет такого — родитель ещё открыт
+            std::vector<std::size_t> open;
+            std::vector<std::string> paths(ev.size());
+            std::vector<double> childNs(ev.size(), 0);
+            std::vector<bool> keep(ev.size(), true);
+            for (std::size_t i = 0; i < ev.size(); ++i) {
+                while (!open.empty() && (ev[open.back()].depth >= ev[i].depth
+                                         || ev[open.back()].end < ev[i].end))
+                    open.pop_back();
+                if (ev[i].depth > 0 && (open.empty() || ev[open.back()].depth + 1 != ev[i].depth)) {
+                    keep[i] = false;
+                    continue;
+                }
+                double ns = double(ev[i].end - ev[i].start) * nsPerTick;
+                if (open.empty()) {
+                    paths[i] = ev[i].name;
+                } else {
+                    paths[i] = paths[open.back()] + " / " + ev[i].name;
+                    childNs[open.back()] += ns;
+                }
+                open.push_back(i);
+            }
+            for (std::size_t i = 0; i < ev.size(); ++i) {
+                if (!keep[i]) continue;
+                Acc& a = acc[paths[i]];
+                a.depth = ev[i].depth;
+                a.self += double(ev[i].end - ev[i].start) * nsPerTick - childNs[i];
+                a.samples.push_back(double(ev[i].end - ev[i].start) * nsPerTick);
+            }
+        }
+
+        std::vector<Stats> out;
+        for (auto& [path, a] : acc) {
+            Stats s;
+            s.path = path;
+            s.depth = a.depth;
+            s.calls = a.samples.size();
+            s.self = a.self;
+            std::sort(a.samples.begin(), a.samples.end());
+            for (double x : a.samples) s.total += x;
+            s.min = a.samples.front();
+            s.max = a.samples.back();
+            auto pct = [&](double q) { return a.samples[std::size_t(q * double(a.samples.size() - 1))]; };
+            s.p50 = pct(0.5);
+            s.p90 = pct(0.9);
+            s.p99 = pct(0.99);
+            out.push_back(std::move(s));
+        }
+        return out;
+    }
+
+    // Текстовый отчёт: дерево областей, время в микросекундах
+    void report(std::ostream& o = std::cout) {
+        std::vector<Stats> stats = collect();
+        std::ios saved(nullptr);
+        saved.copyfmt(o);
+        column(o, "область", 40, true);
+        column(o, "вызовов", 10);
+        column(o, "всего", 12);
+        column(o, "self", 12);
+        column(o, "мин", 10);
+        column(o, "p50", 10);
+        column(o, "p90", 10);
+        column(o, "p99", 10);
+        column(o, "макс", 12);
+        o << "   (мкс)\n";
+        o << std::fixed << std::setprecision(1);
+        for (const Stats& s : stats) {
+            std::size_t cut = s.path.rfind(" / ");
+            std::string name = std::string(2 * s.depth, ' ')
+                + (cut == std::string::npos ? s.path : s.path.substr(cut + 3));
+            column(o, name, 40, true);
+            o << std::setw(10) << s.calls << std::setw(12) << s.total / 1e3
+              << std::setw(12) << s.self / 1e3 << std::setw(10) << s.min / 1e3
+              << std::setw(10) << s.p50 / 1e3 << std::setw(10) << s.p90 / 1e3
+              << std::setw(10) << s.p99 / 1e3 << std::setw(12) << s.max / 1e3 << '\n';
+        }
+        o.copyfmt(saved);
+        std::size_t dropped = droppedEvents();
+        if (dropped) o << "потеряно событий (буфер полон): " << dropped << '\n';
+    }
+
+    // Trace Event Format: массив событий "X" (начало и длительность в мкс)
+    bool writeChromeTrace(const std::string& path) {
+        double nsPerTick = calibrate();
+        std::ofstream f(path);
+        if (!f) return false;
+        f << "{\"traceEvents\":[";
+        bool first = true;
+        f << std::fixed << std::setprecision(3);
+        for (auto& buf : snapshotBuffers()) {
+            for (const Event& e : buf.second) {
+                f << (first ? "\n" : ",\n") << "{\"name\":\"";
+                for (const char* p = e.name; *p; ++p) {
+                    if (*p == '"' || *p == '\\') f << '\\';
+                    f << *p;
+                }
+                f << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buf.first
+                  << ",\"ts\":" << double(e.start - origin) * nsPerTick / 1e3
+                  << ",\"dur\":" << double(e.end - e.start) * nsPerTick / 1e3 << '}';
+                first = false;
+            }
+        }
+        f << "\n]}\n";
+        return bool(f);
+    }
+
+    // Сбрасывает накопленные события; потоки при этом не должны быть внутри областей
+    void reset() {
+        std::lock_guard<std::mutex> lock(m);
+        for (auto& b : buffers) b->clear();
+    }
+
+    std::size_t droppedEvents() {
+        std::lock_guard<std::mutex> lock(m);
+        std::size_t n = 0;
+        for (auto& b : buffers) n += b->dropped;
+        return n;
+    }
+
+private:
+    struct Acc {
+        std::uint32_t depth = 0;
+        double self = 0;
+        std::vector<double> samples;
+    };
+
+    // Столбец шириной width символов (UTF-8: считаются кодовые точки, а не байты)
+    static void column(std::ostream& o, const std::string& s, std::size_t width, bool left = false) {
+        std::size_t len = 0;
+        for (unsigned char c : s) len += (c & 0xC0) != 0x80;
+        std::string pad(len < width ? width - len : 0, ' ');
+        o << (left ? s + pad : pad + s);
+    }
+
+    Profiler() : origin(ticks()), originClock(std::chrono::steady_clock::now()) {}
+
+    ThreadBuffer* registerThread() {
+        std::lock_guard<std::mutex> lock(m);
+        buffers.push_back(std::make_unique<ThreadBuffer>(std::uint32_t(buffers.size() + 1)));
+        return buffers.back().get();
+    }
+
+    std::vector<std::pair<std::uint32_t, std::vector<Event>>> snapshotBuffers() {
+        std::lock_guard<std::mutex> lock(m);
+        std::vector<std::pair<std::uint32_t, std::vector<Event>>> out;
+        for (auto& b : buffers) out.emplace_back(b->tid, b->snapshot());
+        return out;
+    }
+
+    // Наносекунд на такт: отношение steady_clock к ticks() с момента
+    // создания профилировщика (не меньше 20 мс для точности)
+    double calibrate() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        using namespace std::chrono;
+        while (steady_clock::now() - originClock < milliseconds(20)) std::this_thread::yield();
+        std::uint64_t t = ticks();
+        double ns = double(duration_cast<nanoseconds>(steady_clock::now() - originClock).count());
+        return ns / double(t - origin);
+#else
+        return 1.0;
+#endif
+    }
+
+    std::uint64_t origin;
+    std::chrono::steady_clock::time_point originClock;
+    std::mutex m;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+// RAII-область: name должен жить до отчёта (обычно строковый литерал)
+class ProfileScope {
+    Profiler::ThreadBuffer& b;
+    const char* name;
+    std::uint64_t start;
+public:
+    explicit ProfileScope(const char* n)
+        : b(Profiler::local()), name(n) {
+        ++b.depth;
+        start = Profiler::ticks();
+    }
+
+    ~ProfileScope() {
+        std::uint64_t end = Profiler::ticks();
+        b.push({name, start, end, --b.depth});
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define DCP_PROFILE_CONCAT2(a, b) a##b
+#define DCP_PROFILE_CONCAT(a, b) DCP_PROFILE_CONCAT2(a, b)
+
+#if DCP_PROFILE
+#define PROFILE_SCOPE(name) ProfileScope DCP_PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#endif
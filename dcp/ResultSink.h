@@ -0,0 +1,144 @@
+#pragma once
+
+// Результаты замеров в формате JSON lines: одна строка — один случай с
+// параметрами, статистикой, всеми повторами, ревизией git и описанием
+// машины. Файл дописывается, так что в нём копится история прогонов;
+// сравнивает два набора dcp/bench_compare.py.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "Bench.h"
+
+#if defined(_WIN32)
+#define DCP_POPEN _popen
+#define DCP_PCLOSE _pclose
+#else
+#include <sys/utsname.h>
+#include <unistd.h>
+#define DCP_POPEN popen
+#define DCP_PCLOSE pclose
+#endif
+
+namespace bench {
+
+inline std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += char(c);
+        } else if (c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof buf, "\\u%04x", c);
+            out += buf;
+        } else {
+            out += char(c);
+        }
+    }
+    return out + '"';
+}
+
+// Первая строка вывода команды (без перевода строки) или пусто
+inline std::string commandLine(const char* cmd) {
+    std::string out;
+    if (FILE* p = DCP_POPEN(cmd, "r")) {
+        char buf[256];
+        if (std::fgets(buf, sizeof buf, p)) out = buf;
+        DCP_PCLOSE(p);
+    }
+    while (!out.empty() && (out.back() == '\n' || out.back() == '\r')) out.pop_back();
+    return out;
+}
+
+// Ревизия: задаётся при сборке (-DDCP_GIT_REV=\"...\") или спрашивается у git
+inline std::string gitRevision() {
+#ifdef DCP_GIT_REV
+    return DCP_GIT_REV;
+#else
+#if defined(_WIN32)
+    std::string rev = commandLine("git describe --always --dirty 2>NUL");
+#else
+    std::string rev = commandLine("git describe --always --dirty 2>/dev/null");
+#endif
+    return rev.empty() ? "unknown" : rev;
+#endif
+}
+
+inline std::string hostJson() {
+    std::string host = "unknown", os = "unknown", cpu;
+#if defined(_WIN32)
+    char name[256];
+    DWORD size = sizeof name;
+    if (GetComputerNameA(name, &size)) host = name;
+    os = "Windows";
+#else
+    char name[256];
+    if (gethostname(name, sizeof name) == 0) {
+        name[sizeof name - 1] = 0;
+        host = name;
+    }
+    utsname u;
+    if (uname(&u) == 0) os = std::string(u.sysname) + " " + u.release + " " + u.machine;
+    std::ifstream info("/proc/cpuinfo");
+    for (std::string line; cpu.empty() && std::getline(info, line);)
+        if (line.rfind("model name", 0) == 0) cpu = line.substr(line.find(':') + 2);
+#endif
+#if defined(__clang__)
+    std::string compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    std::string compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    std::string compiler = "msvc " + std::to_string(_MSC_VER);
+#else
+    std::string compiler = "unknown";
+#endif
+    std::ostringstream o;
+    o << "{\"name\":" << jsonString(host) << ",\"os\":" << jsonString(os)
+      << ",\"cpu\":" << jsonString(cpu) << ",\"cores\":" << std::thread::hardware_concurrency()
+      << ",\"compiler\":" << jsonString(compiler) << '}';
+    return o.str();
+}
+
+class JsonLinesSink {
+    std::ofstream f;
+    std::string common;   // ревизия, машина, время — одинаковы для всего прогона
+
+public:
+    explicit JsonLinesSink(const std::string& path) : f(path, std::ios::app) {
+        long long now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        common = ",\"git\":" + jsonString(gitRevision()) + ",\"host\":" + hostJson()
+               + ",\"time\":" + std::to_string(now);
+    }
+
+    explicit operator bool() const { return bool(f); }
+
+    void write(const Result& r, const Options& o) {
+        char num[64];
+        auto d = [&](double v) {
+            if (!std::isfinite(v)) return std::string("null");   // nan/inf в JSON не бывает
+            std::snprintf(num, sizeof num, "%.6g", v);
+            return std::string(num);
+        };
+        f << "{\"name\":" << jsonString(r.name)
+          << ",\"params\":{\"iterations\":" << r.iterations << ",\"samples\":" << r.ns.size()
+          << ",\"sample_time\":" << d(o.sampleTime) << ",\"warmup\":" << d(o.warmup)
+          << ",\"cpu\":" << o.cpu << '}'
+          << ",\"stats\":{\"median_ns\":" << d(r.median) << ",\"mad_ns\":" << d(r.mad)
+          << ",\"ci_low_ns\":" << d(r.ciLow) << ",\"ci_high_ns\":" << d(r.ciHigh)
+          << ",\"min_ns\":" << d(r.min)
+          << ",\"items_per_iter\":" << d(r.items) << ",\"bytes_per_iter\":" << d(r.bytes) << '}'
+          << ",\"samples_ns\":[";
+        for (std::size_t i = 0; i < r.ns.size(); ++i) f << (i ? "," : "") << d(r.ns[i]);
+        f << ']' << common << "}\n";
+        f.flush();
+    }
+};
+
+} // namespace bench
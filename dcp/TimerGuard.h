@@ -1,20 +1,69 @@
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <string_view>
+#include "PerfCounters.h"
 
+// Печатает «msg миллисекунды» при выходе из области. В режиме Counters
+// дописывает к строке IPC и счётчики на одну операцию (ops — сколько
+// операций выполнено в области):
+//     цикл 12 | IPC 1.84, тактов/оп 3.12, L1d-промахов/оп 0.001, ... [perf]
 class TimerGuard {
+public:
+    enum class Mode { Time, Counters };
+
+private:
     std::string m;
     std::ostream& o;
     std::chrono::steady_clock::time_point s;
+    std::unique_ptr<PerfCounters> pc;
+    std::uint64_t ops = 1;
+
 public:
     TimerGuard(std::string_view msg = "", std::ostream& out = std::cout)
         : m(msg), o(out), s(std::chrono::steady_clock::now()) {}
 
+    TimerGuard(std::string_view msg, std::ostream& out, Mode mode, std::uint64_t opCount = 1)
+        : m(msg), o(out), ops(opCount ? opCount : 1) {
+        if (mode == Mode::Counters) {
+            pc = std::make_unique<PerfCounters>();
+            pc->start();
+        }
+        s = std::chrono::steady_clock::now();
+    }
+
+    void setOps(std::uint64_t n) { ops = n ? n : 1; }
+
     ~TimerGuard() {
+        auto e = std::chrono::steady_clock::now();
+        PerfCounters::Sample c;
+        if (pc) c = pc->stop();
         o << m << ' '
-          << std::chrono::duration_cast<std::chrono::milliseconds>(
-                 std::chrono::steady_clock::now() - s).count()
-          << '\n';
+          << std::chrono::duration_cast<std::chrono::milliseconds>(e - s).count();
+        if (pc) {
+            o << " |";
+            const char* sep = " ";
+            auto put = [&](const char* name, double v, const char* fmt) {
+                char buf[64];
+                std::snprintf(buf, sizeof buf, fmt, v);
+                o << sep << name << ' ' << buf;
+                sep = ", ";
+            };
+            double n = double(ops);
+            if (c.valid[PerfCounters::Cycles] && c.valid[PerfCounters::Instructions] && c.value[PerfCounters::Cycles] > 0)
+                put("IPC", c.value[PerfCounters::Instructions] / c.value[PerfCounters::Cycles], "%.2f");
+            if (c.valid[PerfCounters::Cycles]) put("тактов/оп", c.value[PerfCounters::Cycles] / n, "%.3g");
+            if (c.valid[PerfCounters::Instructions]) put("инструкций/оп", c.value[PerfCounters::Instructions] / n, "%.3g");
+            if (c.valid[PerfCounters::L1Misses]) put("L1d-промахов/оп", c.value[PerfCounters::L1Misses] / n, "%.3g");
+            if (c.valid[PerfCounters::LlcMisses]) put("LLC-промахов/оп", c.value[PerfCounters::LlcMisses] / n, "%.3g");
+            if (c.valid[PerfCounters::BranchMisses]) put("ошибок ветвлений/оп", c.value[PerfCounters::BranchMisses] / n, "%.3g");
+            if (c.valid[PerfCounters::PageFaults]) put("отказов страниц", c.value[PerfCounters::PageFaults], "%.0f");
+            if (c.valid[PerfCounters::ContextSwitches]) put("переключений", c.value[PerfCounters::ContextSwitches], "%.0f");
+            o << " [" << pc->source() << ']';
+        }
+        o << '\n';
     }
 };
@@ -0,0 +1,155 @@
+"""Сравнение двух наборов результатов dcp/bench (--json, формат JSON lines).
+
+    python3 dcp/bench_compare.py base.jsonl new.jsonl [--threshold 5]
+        [--limit 'bigint/*=10' ...] [--alpha 0.01]
+
+Для каждого случая, который есть в обоих файлах, берётся последняя запись
+и сравниваются повторы (samples_ns) критерием Манна–Уитни. Регрессия —
+медиана выросла больше порога и различие значимо (p < alpha). Порог по
+умолчанию задаёт --threshold (в процентах), для отдельных случаев —
+--limit шаблон=проценты (шаблоны как в fnmatch, побеждает первый
+подошедший). Код возврата: 0 — регрессий нет, 1 — есть, 2 — ошибка ввода.
+"""
+
+import argparse
+import fnmatch
+import json
+import math
+import sys
+
+
+class InputError(Exception):
+    """Файл результатов не читается: код возврата 2, а не 1."""
+
+
+def load(path):
+    runs = {}
+    with open(path, encoding='utf-8') as f:
+        for n, line in enumerate(f, 1):
+            line = line.strip()
+            if not line:
+                continue
+            try:
+                rec = json.loads(line)
+            except json.JSONDecodeError as e:
+                raise InputError(f'{path}:{n}: не JSON: {e}')
+            # поля, нужные для сравнения, проверяем сразу, а не в цикле по случаям
+            try:
+                name, median, samples = rec['name'], rec['stats']['median_ns'], rec['samples_ns']
+            except KeyError as e:
+                raise InputError(f'{path}:{n}: нет поля {e}')
+            except TypeError:
+                raise InputError(f'{path}:{n}: запись не объект с полями name, stats, samples_ns')
+            if not isinstance(name, str) or not isinstance(samples, list) \
+                    or not all(x is None or isinstance(x, (int, float)) for x in [median] + samples):
+                raise InputError(f'{path}:{n}: неверный тип name, median_ns или samples_ns')
+            runs[name] = rec   # последняя запись побеждает
+    return runs
+
+
+def mann_whitney(a, b):
+    """Двусторонний p для U-критерия (нормальное приближение с поправкой
+    на связки и непрерывность)."""
+    n1, n2 = len(a), len(b)
+    if n1 == 0 or n2 == 0:
+        return 1.0
+    pooled = sorted([(x, 0) for x in a] + [(x, 1) for x in b])
+    ranks = [0.0] * len(pooled)
+    ties = 0.0
+    i = 0
+    while i < len(pooled):
+        j = i
+        while j + 1 < len(pooled) and pooled[j + 1][0] == pooled[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2 + 1
+        t = j - i + 1
+        ties += t ** 3 - t
+        i = j + 1
+    r1 = sum(r for r, (_, g) in zip(ranks, pooled) if g == 0)
+    u = r1 - n1 * (n1 + 1) / 2
+    n = n1 + n2
+    var = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)))
+    if var <= 0:
+        return 1.0
+    z = (abs(u - n1 * n2 / 2) - 0.5) / math.sqrt(var)
+    return math.erfc(max(z, 0) / math.sqrt(2))
+
+
+def limit_for(name, limits, default):
+    for pattern, pct in limits:
+        if fnmatch.fnmatchcase(name, pattern):
+            return pct
+    return default
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Сравнение результатов dcp/bench')
+    ap.add_argument('base')
+    ap.add_argument('new')
+    ap.add_argument('--threshold', type=float, default=5.0,
+                    help='допустимое замедление медианы, %% (по умолчанию 5)')
+    ap.add_argument('--limit', action='append', default=[], metavar='ШАБЛОН=ПРОЦЕНТЫ',
+                    help='свой порог для случаев по шаблону имени')
+    ap.add_argument('--alpha', type=float, default=0.01,
+                    help='уровень значимости (по умолчанию 0.01)')
+    args = ap.parse_args()
+
+    limits = []
+    for item in args.limit:
+        pattern, sep, pct = item.rpartition('=')
+        try:
+            limits.append((pattern, float(pct)))
+        except ValueError:
+            sep = ''
+        if not sep:
+            print(f'Неверный --limit: {item}', file=sys.stderr)
+            return 2
+
+    try:
+        base, new = load(args.base), load(args.new)
+    except (OSError, UnicodeDecodeError, InputError) as e:
+        print(e, file=sys.stderr)
+        return 2
+
+    some_base, some_new = next(iter(base.values()), None), next(iter(new.values()), None)
+    if some_base and some_new:
+        hb, hn = some_base.get('host', {}), some_new.get('host', {})
+        if (hb.get('cpu'), hb.get('name')) != (hn.get('cpu'), hn.get('name')):
+            print(f'Внимание: разные машины ({hb.get("name")}, {hb.get("cpu")}'
+                  f' против {hn.get("name")}, {hn.get("cpu")})')
+        print(f'{some_base.get("git", "?")} → {some_new.get("git", "?")}')
+
+    regressions = 0
+    print(f'{"случай":40} {"было, нс":>12} {"стало, нс":>12} {"изменение":>10} {"p":>8}  итог')
+    for name in sorted(set(base) & set(new)):
+        a, b = base[name], new[name]
+        ma, mb = a['stats']['median_ns'], b['stats']['median_ns']
+        if ma is None or mb is None:   # null — замер не дал конечного числа
+            print(f'{name:40} нет медианы')
+            continue
+        change = (mb / ma - 1) * 100 if ma > 0 else 0.0
+        p = mann_whitney([x for x in a['samples_ns'] if x is not None],
+                         [x for x in b['samples_ns'] if x is not None])
+        limit = limit_for(name, limits, args.threshold)
+        if p < args.alpha and change > limit:
+            verdict = f'РЕГРЕССИЯ (порог {limit:g}%)'
+            regressions += 1
+        elif p < args.alpha and change < -limit:
+            verdict = 'ускорение'
+        else:
+            verdict = '~'
+        print(f'{name:40} {ma:12.1f} {mb:12.1f} {change:+9.1f}% {p:8.2g}  {verdict}')
+
+    for name in sorted(set(base) - set(new)):
+        print(f'{name:40} нет в {args.new}')
+    for name in sorted(set(new) - set(base)):
+        print(f'{name:40} новый случай')
+
+    if regressions:
+        print(f'Регрессий: {regressions}')
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,23 +1,100 @@
-#include <thread>
-#include <windows.h>
-#include <clocale>
+// Замеры по всем заданиям. Сборка из корня репозитория:
+//
+//     g++ -std=c++17 -O2 -pthread -DDCP_BENCH dcp/main.cpp Z2.cpp Z2_2.cpp Z5.cpp Z7.cpp Z8.cpp -o dcp/bench
+//
+// С -DDCP_BENCH файлы Z*.cpp вместо своего main регистрируют случаи
+// замеров (BENCH_CASE). Запуск:
+//
+//     dcp/bench [--filter подстрока] [--samples N] [--time сек] [--warmup сек] [--pin ядро]
+//               [--counters] [--json файл] [--list]
+//
+// --counters: после замера случай прогоняется ещё раз под TimerGuard со
+// счётчиками (IPC, промахи кэша и ветвлений на операцию).
+// --json: дописать результаты в файл JSON lines (см. ResultSink.h); два
+// таких файла сравнивает dcp/bench_compare.py.
+
 #include <iostream>
+#include <memory>
+#include <string>
+#include "Bench.h"
+#include "Profiler.h"
+#include "ResultSink.h"
 #include "TimerGuard.h"
 
-int main() {
-    {
-        SetConsoleOutputCP(CP_UTF8);
+BENCH_CASE("loop/volatile_1e7", [](bench::State& st) {
+    while (st.next()) {
         int g = 0;
-        TimerGuard t("цикл");
         for (volatile int i = 0; i < 10000000; ++i) {
             g++;
-         }
+        }
+        bench::DoNotOptimize(g);
+    }
+    st.setItems(1e7);
+});
+
+BENCH_CASE("profiler/empty_scope", [](bench::State& st) {
+    Profiler::local().reserve(1000);
+    while (st.next()) {
+        for (int i = 0; i < 1000; ++i) {
+            PROFILE_SCOPE("empty");
+        }
+        st.pause();
+        Profiler::instance().reset();
+        st.resume();
+    }
+    st.setItems(1000);
+});
+
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    bench::Options o;
+    bool counters = false;
+    std::string json;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (a == "--list") {
+            for (const bench::Case& c : bench::registry()) std::cout << c.name << '\n';
+            return 0;
+        } else if (a == "--filter" && hasValue) {
+            o.filter = argv[++i];
+        } else if (a == "--samples" && hasValue) {
+            o.samples = std::stoi(argv[++i]);
+        } else if (a == "--time" && hasValue) {
+            o.sampleTime = std::stod(argv[++i]);
+        } else if (a == "--warmup" && hasValue) {
+            o.warmup = std::stod(argv[++i]);
+        } else if (a == "--pin" && hasValue) {
+            o.cpu = std::stoi(argv[++i]);
+        } else if (a == "--json" && hasValue) {
+            json = argv[++i];
+        } else if (a == "--counters") {
+            counters = true;
+        } else {
+            std::cerr << "Неизвестный аргумент: " << a << '\n';
+            return 1;
+        }
     }
 
-    {
-        TimerGuard t("sleep 150 ms");
-        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    std::unique_ptr<bench::JsonLinesSink> sink;
+    if (!json.empty()) {
+        sink = std::make_unique<bench::JsonLinesSink>(json);
+        if (!*sink) {
+            std::cerr << "Не удалось открыть " << json << '\n';
+            return 1;
+        }
     }
 
+    TimerGuard t("всего, мс:");
+    bench::runAll(o, std::cout, [&](const bench::Case& c, const bench::Result& r) {
+        if (sink) sink->write(r, o);
+        if (!counters) return;
+        double perIteration = r.items > 0 ? r.items : 1;
+        TimerGuard g("  один повтор, мс:", std::cout, TimerGuard::Mode::Counters,
+                     std::uint64_t(double(r.iterations) * perIteration));
+        bench::runOnce(c, r.iterations);
+    });
     return 0;
-}
\ No newline at end of file
+}